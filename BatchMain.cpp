@@ -0,0 +1,62 @@
+#include "BatchRunner.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+// Runs a parameter sweep headless, one simulation per task on a work-stealing pool.
+// Usage: Batch <sweep file> <results.csv> [threads]
+
+// "-1" parses as a huge count, anything past this is taken as a typo
+const unsigned long BATCH_MAX_THREADS = 4096;
+
+void PrintUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " <sweep file> <results.csv> [threads]\n";
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3 || argc > 4)
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    unsigned int threadCount = std::thread::hardware_concurrency();
+    if (argc == 4)
+    {
+        char* end = nullptr;
+        unsigned long threads = std::strtoul(argv[3], &end, 10);
+        if (end == argv[3] || *end != '\0' || threads > BATCH_MAX_THREADS)
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        threadCount = (unsigned int)threads;
+    }
+    threadCount = std::max(1u, threadCount);
+
+    SweepSpec spec;
+    std::string error;
+    if (!spec.Load(argv[1], error))
+    {
+        std::cerr << "Error loading sweep: " << error << "\n";
+        return 1;
+    }
+
+    BatchRunner runner(spec, threadCount);
+    size_t runCount = runner.ExpandRuns().size();
+
+    auto start = std::chrono::steady_clock::now();
+    if (!runner.Run(argv[2]))
+    {
+        std::cerr << "Error writing results to " << argv[2] << "\n";
+        return 1;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << runCount << " runs on " << threadCount << " threads in " << elapsed.count() << " s ("
+        << (elapsed.count() > 0 ? runCount * 3600.0 / elapsed.count() : 0.0) << " runs/hour)\n";
+    return 0;
+}
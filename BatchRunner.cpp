@@ -0,0 +1,231 @@
+#include "BatchRunner.hpp"
+#include "FieldFile.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <sstream>
+
+namespace
+{
+    bool ParseNumberList(const std::string& values, std::vector<unsigned long long>& numbers)
+    {
+        std::istringstream stream(values);
+        std::string token;
+        numbers.clear();
+
+        while (stream >> token)
+        {
+            size_t range = token.find("..");
+            try
+            {
+                if (range == std::string::npos)
+                {
+                    numbers.push_back(std::stoull(token));
+                    continue;
+                }
+
+                unsigned long long from = std::stoull(token.substr(0, range));
+                unsigned long long to = std::stoull(token.substr(range + 2));
+                for (unsigned long long value = from; value <= to; value++)
+                    numbers.push_back(value);
+            }
+            catch (const std::exception&)
+            {
+                return false;
+            }
+        }
+        return !numbers.empty();
+    }
+
+    bool ParseSizeList(const std::string& values, std::vector<std::pair<unsigned int, unsigned int>>& sizes)
+    {
+        std::istringstream stream(values);
+        std::string token;
+        sizes.clear();
+
+        while (stream >> token)
+        {
+            unsigned int width, height;
+            if (!ParseSize(token, width, height))
+                return false;
+            sizes.push_back(std::make_pair(width, height));
+        }
+        return !sizes.empty();
+    }
+}
+
+bool SweepSpec::Load(const std::string& filePath, std::string& error)
+{
+    std::ifstream file(filePath);
+    if (!file.is_open())
+    {
+        error = "can't open " + filePath;
+        return false;
+    }
+
+    std::string line;
+    unsigned int lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+        std::replace(line.begin(), line.end(), ',', ' ');
+
+        size_t equals = line.find('=');
+        if (equals == std::string::npos)
+        {
+            if (line.find_first_not_of(" \t\r") != std::string::npos)
+            {
+                error = "line " + std::to_string(lineNumber) + ": expected key = values";
+                return false;
+            }
+            continue;
+        }
+
+        std::istringstream keyStream(line.substr(0, equals));
+        std::string key;
+        keyStream >> key;
+        std::string values = line.substr(equals + 1);
+        std::string word;
+        std::istringstream(values) >> word;
+        std::transform(word.begin(), word.end(), word.begin(), [](char c) { return (char)tolower(c); });
+
+        bool parsed = true;
+        if (key == "randomChance")
+            parsed = ParseNumberList(values, randomChances) && std::find(randomChances.begin(), randomChances.end(), 0ull) == randomChances.end();
+        else if (key == "randomChanceBloody")
+            parsed = ParseNumberList(values, randomChancesBloody);
+        else if (key == "seeds")
+            parsed = ParseNumberList(values, seeds);
+        else if (key == "sizes")
+            parsed = ParseSizeList(values, sizes);
+        else if (key == "generations")
+        {
+            std::vector<unsigned long long> limit;
+            parsed = ParseNumberList(values, limit) && limit.size() == 1;
+            if (parsed)
+                generationLimit = limit[0];
+        }
+        else if (key == "rule")
+        {
+            parsed = word == "classic" || word == "bloody" || word == "table";
+            rule = word == "classic" ? CellRule::Classic : (word == "table" ? CellRule::Table : CellRule::Bloody);
+        }
+        else if (key == "table")
+            parsed = TableRule::Parse(word, table);
+        else if (key == "topology")
+        {
+            parsed = word == "deadedge" || word == "torus";
+            topology = word == "torus" ? FieldTopology::Torus : FieldTopology::DeadEdge;
+        }
+        else
+        {
+            error = "line " + std::to_string(lineNumber) + ": unknown key " + key;
+            return false;
+        }
+
+        if (!parsed)
+        {
+            error = "line " + std::to_string(lineNumber) + ": bad value for " + key;
+            return false;
+        }
+    }
+    return true;
+}
+
+BatchRunner::BatchRunner(const SweepSpec& spec, unsigned int threadCount)
+    : spec(spec), threadCount(threadCount)
+{
+}
+
+std::vector<BatchRun> BatchRunner::ExpandRuns() const
+{
+    std::vector<BatchRun> runs;
+
+    for (const auto& size : spec.sizes)
+        for (unsigned long long randomChance : spec.randomChances)
+            for (unsigned long long randomChanceBloody : spec.randomChancesBloody)
+                for (unsigned long long seed : spec.seeds)
+                    runs.push_back(BatchRun{ runs.size(), size.first, size.second, randomChance, randomChanceBloody, seed });
+    return runs;
+}
+
+BatchResult BatchRunner::RunOne(const BatchRun& run, const SweepSpec& spec)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    Simulation simulation(run.width, run.height, run.randomChance, run.randomChanceBloody);
+    simulation.SetRule(spec.rule);
+    simulation.SetRuleTable(spec.table.birth, spec.table.survive);
+    simulation.SetTopology(spec.topology);
+    simulation.Seed(run.seed);
+    simulation.Randomize();
+
+    // hashes of the last two generations, indexed by generation parity. A repeated
+    // field only means a cycle when no random draw can change what follows it.
+    uint64_t hashes[2] = { simulation.Hash(), 0 };
+    bool deterministic = spec.rule != CellRule::Bloody || run.randomChanceBloody == 0;
+    std::string outcome = "limit";
+
+    while (simulation.GetGeneration() < spec.generationLimit)
+    {
+        simulation.NextGeneration();
+        if (simulation.IsStable())
+        {
+            outcome = "stable";
+            break;
+        }
+
+        if (!deterministic)
+            continue;
+
+        unsigned long long generation = simulation.GetGeneration();
+        uint64_t hash = simulation.Hash();
+        if (generation >= 2 && hash == hashes[generation % 2])
+        {
+            outcome = "period2";
+            break;
+        }
+        hashes[generation % 2] = hash;
+    }
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return BatchResult{ run, simulation.GetGeneration(), outcome, simulation.CountCells(CELL_ALIVE), simulation.CountCells(CELL_BLOODY), elapsed.count() };
+}
+
+bool BatchRunner::Run(const std::string& outputPath)
+{
+    output.open(outputPath);
+    if (!output.is_open())
+        return false;
+
+    output << "run,width,height,randomChance,randomChanceBloody,seed,generations,outcome,alive,bloody,milliseconds\n";
+
+    std::vector<BatchRun> runs = ExpandRuns();
+    {
+        WorkStealingPool pool(threadCount);
+        for (const BatchRun& run : runs)
+        {
+            pool.Submit([this, run]()
+            {
+                WriteRow(RunOne(run, spec));
+            });
+        }
+        pool.Wait();
+    }
+
+    output.close();
+    return !output.fail();
+}
+
+void BatchRunner::WriteRow(const BatchResult& result)
+{
+    std::ostringstream row;
+    row << result.run.index << ',' << result.run.width << ',' << result.run.height << ','
+        << result.run.randomChance << ',' << result.run.randomChanceBloody << ',' << result.run.seed << ','
+        << result.generations << ',' << result.outcome << ','
+        << result.aliveCells << ',' << result.bloodyCells << ',' << result.milliseconds << '\n';
+
+    std::lock_guard<std::mutex> lock(outputMutex);
+    output << row.str();
+}
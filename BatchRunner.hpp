@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Simulation.hpp"
+#include "WorkStealingPool.hpp"
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+// Parameter sweep read from a text file of "key = values" lines, every
+// combination of the listed values becomes one independent run:
+//   randomChance = 2 3 5 10
+//   randomChanceBloody = 0 500
+//   seeds = 1..100
+//   sizes = 128x128 256x256
+//   generations = 5000
+//   rule = bloody            (classic, bloody or table)
+//   table = B36/S23          (used by the table rule)
+//   topology = torus         (deadedge or torus)
+struct SweepSpec
+{
+    std::vector<unsigned long long> randomChances = { 10 };
+    std::vector<unsigned long long> randomChancesBloody = { 0 };
+    std::vector<unsigned long long> seeds = { 1 };
+    std::vector<std::pair<unsigned int, unsigned int>> sizes = { { 128, 128 } };
+    unsigned long long generationLimit = 1000;
+    CellRule rule = CellRule::Bloody;
+    TableRule table;
+    FieldTopology topology = FieldTopology::DeadEdge;
+
+    bool Load(const std::string& filePath, std::string& error);
+};
+
+struct BatchRun
+{
+    size_t index;
+    unsigned int width, height;
+    unsigned long long randomChance, randomChanceBloody, seed;
+};
+
+struct BatchResult
+{
+    BatchRun run;
+    unsigned long long generations;
+    std::string outcome;
+    unsigned long long aliveCells, bloodyCells;
+    double milliseconds;
+};
+
+class BatchRunner
+{
+public:
+    BatchRunner(const SweepSpec& spec, unsigned int threadCount);
+
+    std::vector<BatchRun> ExpandRuns() const;
+
+    // runs until the field is stable, repeats with period 2 or hits the generation limit
+    static BatchResult RunOne(const BatchRun& run, const SweepSpec& spec);
+
+    // writes one CSV row per run in completion order, returns false if the file can't be written
+    bool Run(const std::string& outputPath);
+
+private:
+    void WriteRow(const BatchResult& result);
+
+    SweepSpec spec;
+    unsigned int threadCount;
+    std::ofstream output;
+    std::mutex outputMutex;
+};
@@ -0,0 +1,180 @@
+#include "CellKernels.hpp"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Times every kernel specialisation on the same random soup.
+// Usage: Benchmark [width height generations]
+
+const unsigned long long BENCHMARK_SEED = 20240611ull;
+const unsigned long long BENCHMARK_RANDOM_CHANCE = 3ull;
+const unsigned long long BENCHMARK_BLOODY_CHANCE = 500ull;
+
+typedef std::vector<std::vector<unsigned int>> LegacyField;
+
+// Previous GameField::NextGeneration loop: nested vectors, bounds checks and rule branches per cell
+bool LegacyStep(LegacyField& gameField, Randomizer& randomizer)
+{
+    static const int neighbourOffsets[8][2] = { {-1,-1}, {0,-1}, {1,-1}, {-1,0}, {1,0}, {-1,1}, {0,1}, {1,1} };
+    bool changed = false;
+    LegacyField tempField(gameField);
+    int width = (int)tempField.size();
+    int height = (int)tempField[0].size();
+
+    for (int x = 0; x < width; x++)
+    {
+        for (int y = 0; y < height; y++)
+        {
+            int aliveNeighboursCount = 0;
+            for (const auto& currentOffset : neighbourOffsets)
+            {
+                int xToCheck = x + currentOffset[0];
+                int yToCheck = y + currentOffset[1];
+                if (xToCheck >= 0 && yToCheck >= 0 && xToCheck < width && yToCheck < height && tempField[xToCheck][yToCheck] == 1)
+                    aliveNeighboursCount++;
+            }
+            if (gameField[x][y] == 2)
+            {
+                int xToMove = x, yToMove = y;
+                for (const auto& currentOffset : neighbourOffsets)
+                {
+                    int xToCheck = x + currentOffset[0];
+                    int yToCheck = y + currentOffset[1];
+                    if (xToCheck >= 0 && yToCheck >= 0 && xToCheck < width && yToCheck < height && tempField[xToCheck][yToCheck] == 1)
+                    {
+                        xToMove = xToCheck;
+                        yToMove = yToCheck;
+                        break;
+                    }
+                }
+                if (xToMove == x && yToMove == y)
+                {
+                    int randomMoveOffset = randomizer.Random<int>(0, 7);
+                    int xToCheck = x + neighbourOffsets[randomMoveOffset][0];
+                    int yToCheck = y + neighbourOffsets[randomMoveOffset][1];
+                    if (xToCheck >= 0 && yToCheck >= 0 && xToCheck < width && yToCheck < height)
+                    {
+                        xToMove = xToCheck;
+                        yToMove = yToCheck;
+                    }
+                }
+                if (gameField[xToMove][yToMove] == 1)
+                {
+                    gameField[xToMove][yToMove] = 2;
+                    changed = true;
+                }
+                else if (gameField[xToMove][yToMove] == 0)
+                {
+                    gameField[x][y] = 0;
+                    changed = true;
+                }
+            }
+            if (gameField[x][y] == 1 && (aliveNeighboursCount < 2 || aliveNeighboursCount > 3))
+            {
+                gameField[x][y] = 0;
+                changed = true;
+            }
+            else if (gameField[x][y] == 0 && aliveNeighboursCount == 3)
+            {
+                gameField[x][y] = 1;
+                changed = true;
+            }
+            else if (gameField[x][y] == 1 && aliveNeighboursCount >= 2 && randomizer.Random<unsigned long long>(1, BENCHMARK_BLOODY_CHANCE) == 1)
+            {
+                gameField[x][y] = 2;
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+template <typename Step>
+double MeasureNanosecondsPerCell(unsigned int width, unsigned int height, unsigned int generations, Step step)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < generations; i++)
+        step();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / ((double)width * height * generations);
+}
+
+template <typename Rule, typename Boundary, typename Grid>
+double MeasureKernel(const Rule& rule, const Grid& seed, unsigned int generations)
+{
+    Grid current(seed), next(seed.GetWidth(), seed.GetHeight());
+    return MeasureNanosecondsPerCell(seed.GetWidth(), seed.GetHeight(), generations, [&]()
+    {
+        StepKernel<Rule, Boundary, Grid>::Run(rule, current, next);
+        std::swap(current, next);
+    });
+}
+
+void PrintRow(const std::string& rule, const std::string& topology, const std::string& storage, double nanosecondsPerCell)
+{
+    std::cout << std::left << std::setw(10) << rule << std::setw(11) << topology << std::setw(10) << storage
+        << std::right << std::fixed << std::setprecision(3) << std::setw(10) << nanosecondsPerCell << " ns/cell"
+        << std::setprecision(1) << std::setw(12) << 1000.0 / nanosecondsPerCell << " Mcells/s\n";
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned int width = 2048, height = 2048, generations = 50;
+    if (argc >= 4)
+    {
+        width = (unsigned int)std::stoul(argv[1]);
+        height = (unsigned int)std::stoul(argv[2]);
+        generations = (unsigned int)std::stoul(argv[3]);
+    }
+
+    Randomizer randomizer;
+    randomizer.Seed(BENCHMARK_SEED);
+
+    ByteGrid bytes(width, height);
+    BitGrid bits(width, height);
+    PlaneGrid planes(width, height);
+    LegacyField legacy(width, std::vector<unsigned int>(height));
+    for (unsigned int x = 0; x < width; x++)
+    {
+        for (unsigned int y = 0; y < height; y++)
+        {
+            if (randomizer.Random<unsigned long long>(1, BENCHMARK_RANDOM_CHANCE) == 1)
+            {
+                bytes.Set(x, y, CELL_ALIVE);
+                bits.Set(x, y, CELL_ALIVE);
+                planes.Set(x, y, CELL_ALIVE);
+                legacy[x][y] = 1;
+            }
+        }
+    }
+
+    std::cout << width << "x" << height << ", " << generations << " generations\n";
+
+    PrintRow("bloody", "dead-edge", "legacy", MeasureNanosecondsPerCell(width, height, generations, [&]() { LegacyStep(legacy, randomizer); }));
+
+    BloodyRule bloody{ BENCHMARK_BLOODY_CHANCE, &randomizer };
+    PrintRow("bloody", "dead-edge", "uint8", MeasureKernel<BloodyRule, DeadEdgeBoundary>(bloody, bytes, generations));
+    PrintRow("bloody", "torus", "uint8", MeasureKernel<BloodyRule, TorusBoundary>(bloody, bytes, generations));
+    PrintRow("bloody", "dead-edge", "planes", MeasureKernel<BloodyRule, DeadEdgeBoundary>(bloody, planes, generations));
+    PrintRow("bloody", "torus", "planes", MeasureKernel<BloodyRule, TorusBoundary>(bloody, planes, generations));
+
+    PrintRow("classic", "dead-edge", "uint8", MeasureKernel<ClassicRule, DeadEdgeBoundary>(ClassicRule(), bytes, generations));
+    PrintRow("classic", "torus", "uint8", MeasureKernel<ClassicRule, TorusBoundary>(ClassicRule(), bytes, generations));
+    PrintRow("classic", "dead-edge", "bits", MeasureKernel<ClassicRule, DeadEdgeBoundary>(ClassicRule(), bits, generations));
+    PrintRow("classic", "torus", "bits", MeasureKernel<ClassicRule, TorusBoundary>(ClassicRule(), bits, generations));
+    PrintRow("classic", "dead-edge", "planes", MeasureKernel<ClassicRule, DeadEdgeBoundary>(ClassicRule(), planes, generations));
+    PrintRow("classic", "torus", "planes", MeasureKernel<ClassicRule, TorusBoundary>(ClassicRule(), planes, generations));
+
+    TableRule highLife;
+    highLife.birth = (1 << 3) | (1 << 6);
+    PrintRow("B36/S23", "dead-edge", "uint8", MeasureKernel<TableRule, DeadEdgeBoundary>(highLife, bytes, generations));
+    PrintRow("B36/S23", "torus", "uint8", MeasureKernel<TableRule, TorusBoundary>(highLife, bytes, generations));
+    PrintRow("B36/S23", "dead-edge", "bits", MeasureKernel<TableRule, DeadEdgeBoundary>(highLife, bits, generations));
+    PrintRow("B36/S23", "torus", "bits", MeasureKernel<TableRule, TorusBoundary>(highLife, bits, generations));
+    PrintRow("B36/S23", "dead-edge", "planes", MeasureKernel<TableRule, DeadEdgeBoundary>(highLife, planes, generations));
+    PrintRow("B36/S23", "torus", "planes", MeasureKernel<TableRule, TorusBoundary>(highLife, planes, generations));
+
+    return 0;
+}
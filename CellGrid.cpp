@@ -0,0 +1,105 @@
+#include "CellGrid.hpp"
+#include <algorithm>
+#include <cstring>
+
+
+ByteGrid::ByteGrid(unsigned int width, unsigned int height)
+    : width(width), height(height), cells(((size_t)width + 2) * height, CELL_DEAD)
+{
+}
+
+void ByteGrid::Clear()
+{
+    std::fill(cells.begin(), cells.end(), CELL_DEAD);
+}
+
+void ByteGrid::CopyFrom(const ByteGrid& other)
+{
+    width = other.width;
+    height = other.height;
+    cells.assign(other.cells.begin(), other.cells.end());
+}
+
+uint64_t ByteGrid::Hash() const
+{
+    const uint8_t* data = Column(0);
+    size_t size = (size_t)width * height;
+    uint64_t hash = 0xCBF29CE484222325ull ^ size;
+    size_t i = 0;
+
+    // FNV style over 8 cells at a time
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * 0x100000001B3ull;
+        hash ^= hash >> 29;
+    }
+    for (; i < size; i++)
+        hash = (hash ^ data[i]) * 0x100000001B3ull;
+    return hash;
+}
+
+BitGrid::BitGrid(unsigned int width, unsigned int height)
+    : width(width), height(height)
+{
+    wordsPerColumn = ((size_t)height + 63) / 64;
+    lastWordMask = height % 64 == 0 ? ~0ull : (1ull << (height % 64)) - 1;
+    words = std::vector<uint64_t>(((size_t)width + 2) * wordsPerColumn, 0);
+}
+
+void BitGrid::Clear()
+{
+    std::fill(words.begin(), words.end(), 0);
+}
+
+void BitGrid::CopyFrom(const BitGrid& other)
+{
+    width = other.width;
+    height = other.height;
+    wordsPerColumn = other.wordsPerColumn;
+    lastWordMask = other.lastWordMask;
+    words.assign(other.words.begin(), other.words.end());
+}
+
+PlaneGrid::PlaneGrid(unsigned int width, unsigned int height)
+    : width(width), height(height)
+{
+    wordsPerColumn = ((size_t)height + 63) / 64;
+    lastWordMask = height % 64 == 0 ? ~0ull : (1ull << (height % 64)) - 1;
+    alive = std::vector<uint64_t>(((size_t)width + 2) * wordsPerColumn, 0);
+    bloody = std::vector<uint64_t>(alive.size(), 0);
+}
+
+void PlaneGrid::Clear()
+{
+    std::fill(alive.begin(), alive.end(), 0);
+    std::fill(bloody.begin(), bloody.end(), 0);
+}
+
+void PlaneGrid::CopyFrom(const PlaneGrid& other)
+{
+    width = other.width;
+    height = other.height;
+    wordsPerColumn = other.wordsPerColumn;
+    lastWordMask = other.lastWordMask;
+    alive.assign(other.alive.begin(), other.alive.end());
+    bloody.assign(other.bloody.begin(), other.bloody.end());
+}
+
+uint64_t PlaneGrid::Hash() const
+{
+    size_t size = (size_t)width * wordsPerColumn;
+    uint64_t hash = 0xCBF29CE484222325ull ^ ((uint64_t)width << 32 | height);
+
+    // FNV style over both planes, a word of each per step
+    const uint64_t* alivePlane = AliveColumn(0);
+    const uint64_t* bloodyPlane = BloodyColumn(0);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ alivePlane[i]) * 0x100000001B3ull;
+        hash = (hash ^ bloodyPlane[i]) * 0x100000001B3ull;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+enum CellState : uint8_t
+{
+    CELL_DEAD = 0,
+    CELL_ALIVE = 1,
+    CELL_BLOODY = 2
+};
+
+// Rectangle of cells, used to refresh only the part of the field that changed
+struct CellRect
+{
+    unsigned int x = 0, y = 0, width = 0, height = 0;
+
+    bool IsEmpty() const { return width == 0 || height == 0; }
+
+    // grows to the bounding box of both rectangles
+    void Include(const CellRect& other)
+    {
+        if (other.IsEmpty())
+            return;
+        if (IsEmpty())
+        {
+            *this = other;
+            return;
+        }
+        unsigned int right = std::max(x + width, other.x + other.width);
+        unsigned int bottom = std::max(y + height, other.y + other.height);
+        x = std::min(x, other.x);
+        y = std::min(y, other.y);
+        width = right - x;
+        height = bottom - y;
+    }
+};
+
+inline unsigned int CountTrailingZeros(uint64_t word)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return (unsigned int)index;
+#else
+    return (unsigned int)__builtin_ctzll(word);
+#endif
+}
+
+inline unsigned int PopCount(uint64_t word)
+{
+#ifdef _MSC_VER
+    return (unsigned int)__popcnt64(word);
+#else
+    return (unsigned int)__builtin_popcountll(word);
+#endif
+}
+
+// One byte per cell, stored column by column. A dead guard column sits on both
+// sides of the field so kernels can read columns -1 and width without checks.
+class ByteGrid
+{
+public:
+    ByteGrid(unsigned int width = 0, unsigned int height = 0);
+
+    unsigned int GetWidth() const { return width; }
+    unsigned int GetHeight() const { return height; }
+
+    uint8_t Get(unsigned int x, unsigned int y) const { return cells[(size_t)(x + 1) * height + y]; }
+    void Set(unsigned int x, unsigned int y, uint8_t state) { cells[(size_t)(x + 1) * height + y] = state; }
+
+    const uint8_t* Column(int x) const { return cells.data() + (size_t)(x + 1) * height; }
+    uint8_t* Column(int x) { return cells.data() + (size_t)(x + 1) * height; }
+
+    void Clear();
+    void CopyFrom(const ByteGrid& other);
+    uint64_t Hash() const;
+
+private:
+    unsigned int width, height;
+    std::vector<uint8_t> cells;
+};
+
+// One bit per cell for two-state rules. Each column is packed along y into
+// 64-bit words and bits past the height always stay zero. Guard columns as in ByteGrid.
+class BitGrid
+{
+public:
+    BitGrid(unsigned int width = 0, unsigned int height = 0);
+
+    unsigned int GetWidth() const { return width; }
+    unsigned int GetHeight() const { return height; }
+    size_t GetWordsPerColumn() const { return wordsPerColumn; }
+    uint64_t GetLastWordMask() const { return lastWordMask; }
+
+    uint8_t Get(unsigned int x, unsigned int y) const { return (uint8_t)((Column(x)[y >> 6] >> (y & 63)) & 1); }
+    void Set(unsigned int x, unsigned int y, uint8_t state)
+    {
+        uint64_t& word = Column(x)[y >> 6];
+        uint64_t bit = 1ull << (y & 63);
+        word = state == CELL_ALIVE ? word | bit : word & ~bit;
+    }
+
+    const uint64_t* Column(int x) const { return words.data() + (size_t)(x + 1) * wordsPerColumn; }
+    uint64_t* Column(int x) { return words.data() + (size_t)(x + 1) * wordsPerColumn; }
+
+    void Clear();
+    void CopyFrom(const BitGrid& other);
+
+private:
+    unsigned int width, height;
+    size_t wordsPerColumn;
+    uint64_t lastWordMask;
+    std::vector<uint64_t> words;
+};
+
+// Two bit planes with the BitGrid layout, 2 bits per cell. A set bit in the alive
+// plane is CELL_ALIVE, in the bloody plane CELL_BLOODY, so a cell state is
+// aliveBit | bloodyBit << 1. Both bits are never set for the same cell.
+class PlaneGrid
+{
+public:
+    PlaneGrid(unsigned int width = 0, unsigned int height = 0);
+
+    unsigned int GetWidth() const { return width; }
+    unsigned int GetHeight() const { return height; }
+    size_t GetWordsPerColumn() const { return wordsPerColumn; }
+    uint64_t GetLastWordMask() const { return lastWordMask; }
+
+    uint8_t Get(unsigned int x, unsigned int y) const
+    {
+        size_t i = WordIndex(x, y);
+        unsigned int bit = y & 63;
+        return (uint8_t)(((alive[i] >> bit) & 1) | (((bloody[i] >> bit) & 1) << 1));
+    }
+    void Set(unsigned int x, unsigned int y, uint8_t state)
+    {
+        size_t i = WordIndex(x, y);
+        uint64_t bit = 1ull << (y & 63);
+        alive[i] = (alive[i] & ~bit) | ((0 - (uint64_t)(state & 1)) & bit);
+        bloody[i] = (bloody[i] & ~bit) | ((0 - (uint64_t)((state >> 1) & 1)) & bit);
+    }
+
+    const uint64_t* AliveColumn(int x) const { return alive.data() + (size_t)(x + 1) * wordsPerColumn; }
+    uint64_t* AliveColumn(int x) { return alive.data() + (size_t)(x + 1) * wordsPerColumn; }
+    const uint64_t* BloodyColumn(int x) const { return bloody.data() + (size_t)(x + 1) * wordsPerColumn; }
+    uint64_t* BloodyColumn(int x) { return bloody.data() + (size_t)(x + 1) * wordsPerColumn; }
+
+    void Clear();
+    void CopyFrom(const PlaneGrid& other);
+    uint64_t Hash() const;
+
+private:
+    size_t WordIndex(unsigned int x, unsigned int y) const { return (size_t)(x + 1) * wordsPerColumn + (y >> 6); }
+
+    unsigned int width, height;
+    size_t wordsPerColumn;
+    uint64_t lastWordMask;
+    std::vector<uint64_t> alive, bloody;
+};
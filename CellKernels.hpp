@@ -0,0 +1,555 @@
+#pragma once
+
+#include "CellGrid.hpp"
+#include "Randomizer.hpp"
+#include <string>
+#include <type_traits>
+#include <utility>
+
+// Step kernels are specialised at compile time on a rule, a boundary and a grid
+// storage. StepGeneration picks the specialisation once per generation so the
+// per-cell loops carry no rule, topology or bounds decisions.
+
+enum class CellRule { Classic, Bloody, Table };
+enum class FieldTopology { DeadEdge, Torus };
+
+// Rule policies
+
+struct ClassicRule
+{
+    static constexpr bool TWO_STATE = true;
+
+    uint8_t Next(uint8_t cell, unsigned int aliveNeighbours) const
+    {
+        // B3/S23 as a birth/survive bit table, keeps the loop free of branches
+        return (uint8_t)(((cell == CELL_ALIVE ? 0x0Cu : 0x08u) >> aliveNeighbours) & 1);
+    }
+
+    // s0..s3 are the bit-sliced neighbour counts of 64 cells
+    uint64_t NextWord(uint64_t alive, uint64_t s0, uint64_t s1, uint64_t s2, uint64_t s3) const
+    {
+        return s1 & ~s2 & ~s3 & (s0 | alive);
+    }
+};
+
+// Life-like B/S rule, bit n of birth/survive is set when n alive neighbours
+// give birth to / keep alive a cell. Defaults to B3/S23.
+struct TableRule
+{
+    static constexpr bool TWO_STATE = true;
+
+    uint16_t birth = 1 << 3;
+    uint16_t survive = (1 << 2) | (1 << 3);
+
+    uint8_t Next(uint8_t cell, unsigned int aliveNeighbours) const
+    {
+        return (uint8_t)(((cell == CELL_ALIVE ? survive : birth) >> aliveNeighbours) & 1);
+    }
+
+    uint64_t NextWord(uint64_t alive, uint64_t s0, uint64_t s1, uint64_t s2, uint64_t s3) const
+    {
+        uint64_t next = 0;
+        for (unsigned int n = 0; n <= 8; n++)
+        {
+            uint64_t count = (n & 1 ? s0 : ~s0) & (n & 2 ? s1 : ~s1) & (n & 4 ? s2 : ~s2) & (n & 8 ? s3 : ~s3);
+            uint64_t keep = ((birth >> n) & 1 ? ~alive : 0) | ((survive >> n) & 1 ? alive : 0);
+            next |= count & keep;
+        }
+        return next;
+    }
+
+    // parses rule strings like "B36/S23"
+    static bool Parse(const std::string& text, TableRule& rule)
+    {
+        TableRule parsed;
+        uint16_t* current = nullptr;
+        parsed.birth = parsed.survive = 0;
+
+        for (char c : text)
+        {
+            if (c == 'B' || c == 'b')
+                current = &parsed.birth;
+            else if (c == 'S' || c == 's')
+                current = &parsed.survive;
+            else if (c >= '0' && c <= '8' && current != nullptr)
+                *current |= 1 << (c - '0');
+            else if (c != '/')
+                return false;
+        }
+        rule = parsed;
+        return true;
+    }
+};
+
+// Green cells follow Conway, bloody cells hunt their alive neighbours. Cells are
+// updated in place in scan order, so this rule runs on byte and plane grids only.
+struct BloodyRule
+{
+    static constexpr bool TWO_STATE = false;
+
+    unsigned long long randomChanceBloody;
+    Randomizer* randomizer;
+};
+
+// Boundary policies
+
+struct DeadEdgeBoundary
+{
+    static constexpr bool WRAPS = false;
+
+    // guard columns of the grids are dead
+    static int NeighbourColumn(int x, unsigned int) { return x; }
+
+    static bool Resolve(int& coord, unsigned int size) { return coord >= 0 && coord < (int)size; }
+};
+
+struct TorusBoundary
+{
+    static constexpr bool WRAPS = true;
+
+    static int NeighbourColumn(int x, unsigned int width) { return x < 0 ? (int)width - 1 : (x >= (int)width ? 0 : x); }
+
+    static bool Resolve(int& coord, unsigned int size)
+    {
+        if (coord < 0)
+            coord += (int)size;
+        else if (coord >= (int)size)
+            coord -= (int)size;
+        return true;
+    }
+};
+
+// Bloody cell update shared by the byte and plane kernels. Neighbours are read
+// from src, the cell itself from dst, which is updated in place in scan order.
+template <typename Boundary>
+struct BloodyCellStep
+{
+    template <typename Grid>
+    static bool Run(const BloodyRule& rule, const Grid& src, Grid& dst, unsigned int x, unsigned int y, unsigned int aliveNeighboursCount)
+    {
+        bool changed = false;
+
+        //bloody cell movement
+        if (dst.Get(x, y) == CELL_BLOODY)
+        {
+            std::pair<unsigned int, unsigned int> moveCoords = SearchForPrey(rule, src, x, y);
+            uint8_t target = dst.Get(moveCoords.first, moveCoords.second);
+            if (target == CELL_ALIVE)
+            {
+                dst.Set(moveCoords.first, moveCoords.second, CELL_BLOODY);
+                changed = true;
+            }
+            else if (target == CELL_DEAD)
+            {
+                dst.Set(x, y, CELL_DEAD);
+                changed = true;
+            }
+        }
+        //green cell generation
+        uint8_t cell = dst.Get(x, y);
+        if (cell == CELL_ALIVE && (aliveNeighboursCount < 2 || aliveNeighboursCount > 3))
+        {
+            dst.Set(x, y, CELL_DEAD);
+            changed = true;
+        }
+        else if (cell == CELL_DEAD && aliveNeighboursCount == 3)
+        {
+            dst.Set(x, y, CELL_ALIVE);
+            changed = true;
+        }
+        //bloody cell generation
+        else if (cell == CELL_ALIVE && aliveNeighboursCount >= 2 && rule.randomChanceBloody != 0)
+        {
+            if (rule.randomizer->Random<unsigned long long>(1, rule.randomChanceBloody) == 1)
+            {
+                dst.Set(x, y, CELL_BLOODY);
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    //Bloody Cell Behaviour function:
+    template <typename Grid>
+    static std::pair<unsigned int, unsigned int> SearchForPrey(const BloodyRule& rule, const Grid& field, unsigned int x, unsigned int y)
+    {
+        static const int neighbourOffsets[8][2] = { { -1,-1 },{ 0,-1 },{ 1,-1 },{ -1,0 },{ 1,0 },{ -1,1 },{ 0,1 },{ 1,1 } };
+
+        for (const auto& currentOffset : neighbourOffsets)
+        {
+            int xToCheck = x + currentOffset[0];
+            int yToCheck = y + currentOffset[1];
+
+            if (Boundary::Resolve(xToCheck, field.GetWidth()) && Boundary::Resolve(yToCheck, field.GetHeight()))
+            {
+                if (field.Get(xToCheck, yToCheck) == CELL_ALIVE)
+                    return std::make_pair(xToCheck, yToCheck);
+            }
+        }
+        int randomMoveOffset = rule.randomizer->Random<int>(0, 7);
+        int xToMove = x + neighbourOffsets[randomMoveOffset][0];
+        int yToMove = y + neighbourOffsets[randomMoveOffset][1];
+        if (Boundary::Resolve(xToMove, field.GetWidth()) && Boundary::Resolve(yToMove, field.GetHeight()))
+            return std::make_pair(xToMove, yToMove);
+        else
+            return std::make_pair(x, y);
+    }
+};
+
+// Alive neighbour counts of 64 cells at once, shared by the bit and plane kernels
+template <typename Boundary>
+struct BitNeighbours
+{
+    // s0..s3 receive the bit-sliced counts of the cells in word i of the middle column
+    static void Count(const uint64_t* left, const uint64_t* middle, const uint64_t* right, size_t i, size_t words, unsigned int height, uint64_t& s0, uint64_t& s1, uint64_t& s2, uint64_t& s3)
+    {
+        uint64_t up, down;
+        s0 = s1 = s2 = s3 = 0;
+
+        Shift(left, i, words, height, up, down);
+        Add(s0, s1, s2, s3, up);
+        Add(s0, s1, s2, s3, left[i]);
+        Add(s0, s1, s2, s3, down);
+        Shift(middle, i, words, height, up, down);
+        Add(s0, s1, s2, s3, up);
+        Add(s0, s1, s2, s3, down);
+        Shift(right, i, words, height, up, down);
+        Add(s0, s1, s2, s3, up);
+        Add(s0, s1, s2, s3, right[i]);
+        Add(s0, s1, s2, s3, down);
+    }
+
+    static unsigned int CountAt(uint64_t s0, uint64_t s1, uint64_t s2, uint64_t s3, unsigned int bit)
+    {
+        return (unsigned int)(((s0 >> bit) & 1) | (((s1 >> bit) & 1) << 1) | (((s2 >> bit) & 1) << 2) | (((s3 >> bit) & 1) << 3));
+    }
+
+private:
+    // bit-sliced counter, adds one neighbour plane to the 4-bit per-cell sums
+    static void Add(uint64_t& s0, uint64_t& s1, uint64_t& s2, uint64_t& s3, uint64_t neighbours)
+    {
+        uint64_t carry0 = s0 & neighbours;
+        s0 ^= neighbours;
+        uint64_t carry1 = s1 & carry0;
+        s1 ^= carry0;
+        uint64_t carry2 = s2 & carry1;
+        s2 ^= carry1;
+        s3 |= carry2;
+    }
+
+    // up holds the neighbours at y - 1 of each bit, down the ones at y + 1
+    static void Shift(const uint64_t* column, size_t i, size_t words, unsigned int height, uint64_t& up, uint64_t& down)
+    {
+        uint64_t previous = i > 0 ? column[i - 1] >> 63 : 0;
+        uint64_t next = i + 1 < words ? column[i + 1] << 63 : 0;
+
+        if constexpr (Boundary::WRAPS)
+        {
+            unsigned int lastBit = (height - 1) & 63;
+            if (i == 0)
+                previous = (column[words - 1] >> lastBit) & 1;
+            if (i + 1 == words)
+                next = (column[0] & 1) << lastBit;
+        }
+        up = (column[i] << 1) | previous;
+        down = (column[i] >> 1) | next;
+    }
+};
+
+template <typename Rule, typename Boundary, typename Grid>
+struct StepKernel;
+
+template <typename Rule, typename Boundary>
+struct StepKernel<Rule, Boundary, ByteGrid>
+{
+    // Writes the next generation of src into dst, returns whether anything changed
+    static bool Run(const Rule& rule, const ByteGrid& src, ByteGrid& dst)
+    {
+        if constexpr (Rule::TWO_STATE)
+            return RunTwoState(rule, src, dst);
+        else
+            return RunBloody(rule, src, dst);
+    }
+
+private:
+    static unsigned int IsAlive(uint8_t cell) { return cell == CELL_ALIVE; }
+
+    static unsigned int CountInterior(const uint8_t* left, const uint8_t* middle, const uint8_t* right, unsigned int y)
+    {
+        return IsAlive(left[y - 1]) + IsAlive(left[y]) + IsAlive(left[y + 1])
+            + IsAlive(middle[y - 1]) + IsAlive(middle[y + 1])
+            + IsAlive(right[y - 1]) + IsAlive(right[y]) + IsAlive(right[y + 1]);
+    }
+
+    static unsigned int CountEdge(const uint8_t* left, const uint8_t* middle, const uint8_t* right, unsigned int y, unsigned int height)
+    {
+        unsigned int aliveNeighbours = 0;
+        for (int offset = -1; offset <= 1; offset++)
+        {
+            int row = (int)y + offset;
+            if (Boundary::Resolve(row, height))
+                aliveNeighbours += IsAlive(left[row]) + IsAlive(right[row]) + (offset != 0 ? IsAlive(middle[row]) : 0);
+        }
+        return aliveNeighbours;
+    }
+
+    static bool RunTwoState(const Rule& rule, const ByteGrid& src, ByteGrid& dst)
+    {
+        unsigned int width = src.GetWidth();
+        unsigned int height = src.GetHeight();
+        bool changed = false;
+
+        if (height == 0)
+            return false;
+
+        for (unsigned int x = 0; x < width; x++)
+        {
+            const uint8_t* left = src.Column(Boundary::NeighbourColumn((int)x - 1, width));
+            const uint8_t* middle = src.Column(x);
+            const uint8_t* right = src.Column(Boundary::NeighbourColumn((int)x + 1, width));
+            uint8_t* out = dst.Column(x);
+            unsigned int difference = 0;
+
+            out[0] = rule.Next(middle[0], CountEdge(left, middle, right, 0, height));
+            difference |= out[0] ^ middle[0];
+
+            for (unsigned int y = 1; y + 1 < height; y++)
+            {
+                out[y] = rule.Next(middle[y], CountInterior(left, middle, right, y));
+                difference |= out[y] ^ middle[y];
+            }
+
+            if (height > 1)
+            {
+                unsigned int y = height - 1;
+                out[y] = rule.Next(middle[y], CountEdge(left, middle, right, y, height));
+                difference |= out[y] ^ middle[y];
+            }
+            changed |= difference != 0;
+        }
+        return changed;
+    }
+
+    static bool RunBloody(const BloodyRule& rule, const ByteGrid& src, ByteGrid& dst)
+    {
+        unsigned int width = src.GetWidth();
+        unsigned int height = src.GetHeight();
+        bool changed = false;
+
+        dst.CopyFrom(src);
+        if (height == 0)
+            return false;
+
+        for (unsigned int x = 0; x < width; x++)
+        {
+            const uint8_t* left = src.Column(Boundary::NeighbourColumn((int)x - 1, width));
+            const uint8_t* middle = src.Column(x);
+            const uint8_t* right = src.Column(Boundary::NeighbourColumn((int)x + 1, width));
+
+            changed |= BloodyCellStep<Boundary>::Run(rule, src, dst, x, 0, CountEdge(left, middle, right, 0, height));
+            for (unsigned int y = 1; y + 1 < height; y++)
+                changed |= BloodyCellStep<Boundary>::Run(rule, src, dst, x, y, CountInterior(left, middle, right, y));
+            if (height > 1)
+                changed |= BloodyCellStep<Boundary>::Run(rule, src, dst, x, height - 1, CountEdge(left, middle, right, height - 1, height));
+        }
+        return changed;
+    }
+};
+
+template <typename Rule, typename Boundary>
+struct StepKernel<Rule, Boundary, BitGrid>
+{
+    static_assert(Rule::TWO_STATE, "bit-packed grids only hold two-state rules");
+
+    static bool Run(const Rule& rule, const BitGrid& src, BitGrid& dst)
+    {
+        unsigned int width = src.GetWidth();
+        unsigned int height = src.GetHeight();
+        size_t words = src.GetWordsPerColumn();
+        uint64_t lastWordMask = src.GetLastWordMask();
+        uint64_t difference = 0;
+
+        if (height == 0)
+            return false;
+
+        for (unsigned int x = 0; x < width; x++)
+        {
+            const uint64_t* left = src.Column(Boundary::NeighbourColumn((int)x - 1, width));
+            const uint64_t* middle = src.Column(x);
+            const uint64_t* right = src.Column(Boundary::NeighbourColumn((int)x + 1, width));
+            uint64_t* out = dst.Column(x);
+
+            for (size_t i = 0; i < words; i++)
+            {
+                uint64_t s0, s1, s2, s3;
+                BitNeighbours<Boundary>::Count(left, middle, right, i, words, height, s0, s1, s2, s3);
+
+                uint64_t next = rule.NextWord(middle[i], s0, s1, s2, s3);
+                if (i + 1 == words)
+                    next &= lastWordMask;
+                out[i] = next;
+                difference |= next ^ middle[i];
+            }
+        }
+        return difference != 0;
+    }
+};
+
+template <typename Rule, typename Boundary>
+struct StepKernel<Rule, Boundary, PlaneGrid>
+{
+    static bool Run(const Rule& rule, const PlaneGrid& src, PlaneGrid& dst)
+    {
+        if constexpr (!Rule::TWO_STATE)
+            dst.CopyFrom(src);
+        return RunColumns(rule, src, dst, 0, src.GetWidth());
+    }
+
+    // Steps columns [begin, end) only, the others of dst are left alone. The bloody
+    // rule updates dst in place, so dst has to hold a copy of src beforehand.
+    static bool RunColumns(const Rule& rule, const PlaneGrid& src, PlaneGrid& dst, unsigned int begin, unsigned int end)
+    {
+        if constexpr (Rule::TWO_STATE)
+            return RunTwoState(rule, src, dst, begin, end);
+        else
+            return RunBloody(rule, src, dst, begin, end);
+    }
+
+private:
+    // two-state rules see bloody cells as dead, so only the alive plane is stepped
+    static bool RunTwoState(const Rule& rule, const PlaneGrid& src, PlaneGrid& dst, unsigned int begin, unsigned int end)
+    {
+        unsigned int width = src.GetWidth();
+        unsigned int height = src.GetHeight();
+        size_t words = src.GetWordsPerColumn();
+        uint64_t lastWordMask = src.GetLastWordMask();
+        uint64_t difference = 0;
+
+        if (height == 0)
+            return false;
+
+        for (unsigned int x = begin; x < end; x++)
+        {
+            const uint64_t* left = src.AliveColumn(Boundary::NeighbourColumn((int)x - 1, width));
+            const uint64_t* middle = src.AliveColumn(x);
+            const uint64_t* right = src.AliveColumn(Boundary::NeighbourColumn((int)x + 1, width));
+            const uint64_t* bloody = src.BloodyColumn(x);
+            uint64_t* out = dst.AliveColumn(x);
+            uint64_t* outBloody = dst.BloodyColumn(x);
+
+            for (size_t i = 0; i < words; i++)
+            {
+                uint64_t s0, s1, s2, s3;
+                BitNeighbours<Boundary>::Count(left, middle, right, i, words, height, s0, s1, s2, s3);
+
+                uint64_t next = rule.NextWord(middle[i], s0, s1, s2, s3);
+                if (i + 1 == words)
+                    next &= lastWordMask;
+                out[i] = next;
+                outBloody[i] = 0;
+                difference |= (next ^ middle[i]) | bloody[i];
+            }
+        }
+        return difference != 0;
+    }
+
+    // The neighbour counts come 64 at a time from the alive plane. Only cells that
+    // can change are visited: alive or bloody ones and dead ones with three alive
+    // neighbours. They are visited in the byte kernel's scan order, so both draw
+    // the same random numbers and produce the same field.
+    static bool RunBloody(const BloodyRule& rule, const PlaneGrid& src, PlaneGrid& dst, unsigned int begin, unsigned int end)
+    {
+        unsigned int width = src.GetWidth();
+        unsigned int height = src.GetHeight();
+        size_t words = src.GetWordsPerColumn();
+        uint64_t lastWordMask = src.GetLastWordMask();
+        bool changed = false;
+
+        if (height == 0)
+            return false;
+
+        for (unsigned int x = begin; x < end; x++)
+        {
+            const uint64_t* left = src.AliveColumn(Boundary::NeighbourColumn((int)x - 1, width));
+            const uint64_t* middle = src.AliveColumn(x);
+            const uint64_t* right = src.AliveColumn(Boundary::NeighbourColumn((int)x + 1, width));
+            const uint64_t* alive = dst.AliveColumn(x);
+            const uint64_t* bloody = dst.BloodyColumn(x);
+
+            for (size_t i = 0; i < words; i++)
+            {
+                uint64_t s0, s1, s2, s3;
+                BitNeighbours<Boundary>::Count(left, middle, right, i, words, height, s0, s1, s2, s3);
+
+                // earlier cells can only turn alive neighbours bloody, so this mask stays a superset
+                uint64_t threeNeighbours = s0 & s1 & ~s2 & ~s3;
+                uint64_t active = alive[i] | bloody[i] | threeNeighbours;
+                if (i + 1 == words)
+                    active &= lastWordMask;
+
+                while (active != 0)
+                {
+                    unsigned int bit = CountTrailingZeros(active);
+                    active &= active - 1;
+                    changed |= BloodyCellStep<Boundary>::Run(rule, src, dst, x, (unsigned int)(i * 64 + bit), BitNeighbours<Boundary>::CountAt(s0, s1, s2, s3, bit));
+                }
+            }
+        }
+        return changed;
+    }
+};
+
+struct StepSettings
+{
+    CellRule rule = CellRule::Bloody;
+    FieldTopology topology = FieldTopology::DeadEdge;
+    TableRule table;
+    unsigned long long randomChanceBloody = 0;
+};
+
+template <typename Rule, typename Grid>
+bool StepWithTopology(const Rule& rule, FieldTopology topology, const Grid& src, Grid& dst)
+{
+    if (topology == FieldTopology::Torus)
+        return StepKernel<Rule, TorusBoundary, Grid>::Run(rule, src, dst);
+    return StepKernel<Rule, DeadEdgeBoundary, Grid>::Run(rule, src, dst);
+}
+
+// Steps columns [begin, end) of a plane grid with the matching kernel, see RunColumns()
+inline bool StepColumns(const StepSettings& settings, Randomizer& randomizer, const PlaneGrid& src, PlaneGrid& dst, unsigned int begin, unsigned int end)
+{
+    bool torus = settings.topology == FieldTopology::Torus;
+    switch (settings.rule)
+    {
+        case CellRule::Table:
+            return torus ? StepKernel<TableRule, TorusBoundary, PlaneGrid>::RunColumns(settings.table, src, dst, begin, end)
+                : StepKernel<TableRule, DeadEdgeBoundary, PlaneGrid>::RunColumns(settings.table, src, dst, begin, end);
+        case CellRule::Bloody:
+        {
+            BloodyRule rule{ settings.randomChanceBloody, &randomizer };
+            return torus ? StepKernel<BloodyRule, TorusBoundary, PlaneGrid>::RunColumns(rule, src, dst, begin, end)
+                : StepKernel<BloodyRule, DeadEdgeBoundary, PlaneGrid>::RunColumns(rule, src, dst, begin, end);
+        }
+        default:
+            return torus ? StepKernel<ClassicRule, TorusBoundary, PlaneGrid>::RunColumns(ClassicRule(), src, dst, begin, end)
+                : StepKernel<ClassicRule, DeadEdgeBoundary, PlaneGrid>::RunColumns(ClassicRule(), src, dst, begin, end);
+    }
+}
+
+// Dispatches to the matching kernel, bit grids run the bloody rule as classic
+template <typename Grid>
+bool StepGeneration(const StepSettings& settings, Randomizer& randomizer, const Grid& src, Grid& dst)
+{
+    switch (settings.rule)
+    {
+        case CellRule::Table:
+            return StepWithTopology(settings.table, settings.topology, src, dst);
+        case CellRule::Bloody:
+            if constexpr (!std::is_same<Grid, BitGrid>::value)
+                return StepWithTopology(BloodyRule{ settings.randomChanceBloody, &randomizer }, settings.topology, src, dst);
+            else
+                return StepWithTopology(ClassicRule(), settings.topology, src, dst);
+        default:
+            return StepWithTopology(ClassicRule(), settings.topology, src, dst);
+    }
+}
@@ -0,0 +1,107 @@
+#include "CheckpointWriter.hpp"
+#include "FieldFile.hpp"
+#include <algorithm>
+
+
+CheckpointWriter::CheckpointWriter(TaskScheduler& scheduler)
+    : writing(false), autosaveGenerations(0), lastAutosaveGeneration(0), autosaveSeconds(0.f), scheduler(scheduler)
+{
+    lastAutosaveTime = std::chrono::steady_clock::now();
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+    Flush();
+}
+
+void CheckpointWriter::SetAutosave(unsigned long long everyGenerations, float everySeconds, const std::string& filePath)
+{
+    autosaveGenerations = everyGenerations;
+    autosaveSeconds = everySeconds;
+    autosavePath = filePath;
+    lastAutosaveTime = std::chrono::steady_clock::now();
+}
+
+void CheckpointWriter::OnGeneration(const Simulation& simulation)
+{
+    if (autosavePath == "" || (autosaveGenerations == 0 && autosaveSeconds <= 0.f))
+        return;
+
+    unsigned long long generation = simulation.GetGeneration();
+    if (generation < lastAutosaveGeneration)
+        lastAutosaveGeneration = generation;
+
+    bool generationsDue = autosaveGenerations != 0 && generation - lastAutosaveGeneration >= autosaveGenerations;
+    bool timeDue = autosaveSeconds > 0.f && std::chrono::steady_clock::now() - lastAutosaveTime >= std::chrono::duration<float>(autosaveSeconds);
+
+    if (generationsDue || timeDue)
+    {
+        lastAutosaveGeneration = generation;
+        lastAutosaveTime = std::chrono::steady_clock::now();
+        Submit(simulation.TakeSnapshot(), autosavePath, true);
+    }
+}
+
+void CheckpointWriter::Submit(std::shared_ptr<const FieldSnapshot> snapshot, const std::string& filePath, bool autosave)
+{
+    bool startWriting;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        auto pending = std::find_if(jobs.begin(), jobs.end(), [&](const Job& job) { return job.autosave && job.filePath == filePath; });
+
+        if (autosave && pending != jobs.end())
+            pending->snapshot = std::move(snapshot);
+        else
+            jobs.push_back(Job{ std::move(snapshot), filePath, autosave });
+
+        // one task drains the queue, it ends when the queue is empty
+        startWriting = !writing;
+        writing = true;
+    }
+    if (startWriting)
+        scheduler.Spawn(WriteJobs());
+}
+
+bool CheckpointWriter::PollResult(CheckpointResult& result)
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+    if (results.empty())
+        return false;
+
+    result = results.front();
+    results.pop_front();
+    return true;
+}
+
+void CheckpointWriter::Flush()
+{
+    std::unique_lock<std::mutex> lock(queueMutex);
+    idle.wait(lock, [this]() { return jobs.empty() && !writing; });
+}
+
+Task CheckpointWriter::WriteJobs()
+{
+    std::unique_lock<std::mutex> lock(queueMutex);
+
+    while (!jobs.empty())
+    {
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        lock.unlock();
+
+        bool success = WriteFileAtomically(job.filePath, EncodeFieldText(job.snapshot->grid));
+
+        lock.lock();
+        results.push_back(CheckpointResult{ job.filePath, job.snapshot->generation, job.autosave, success });
+        if (results.size() > MAX_RESULTS)
+            results.pop_front();
+
+        // other tasks get the worker between two saves
+        lock.unlock();
+        co_await scheduler.Schedule();
+        lock.lock();
+    }
+
+    writing = false;
+    idle.notify_all();
+}
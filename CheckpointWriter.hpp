@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Simulation.hpp"
+#include "TaskScheduler.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+
+struct CheckpointResult
+{
+    std::string filePath;
+    unsigned long long generation;
+    bool autosave, success;
+};
+
+// Encodes and writes field snapshots in a scheduler task that runs while saves
+// are queued. The caller only pays for the snapshot copy, so a stepping task
+// never waits on the disk.
+class CheckpointWriter
+{
+public:
+    explicit CheckpointWriter(TaskScheduler& scheduler);
+    CheckpointWriter(CheckpointWriter const &) = delete;
+    void operator=(CheckpointWriter) = delete;
+    ~CheckpointWriter();
+
+    // 0 disables the generation or the wall time trigger
+    void SetAutosave(unsigned long long everyGenerations, float everySeconds, const std::string& filePath);
+
+    // call at a generation boundary, snapshots and queues an autosave when one is due
+    void OnGeneration(const Simulation& simulation);
+
+    // an autosave still waiting in the queue is replaced by a newer one, explicit saves are always kept
+    void Submit(std::shared_ptr<const FieldSnapshot> snapshot, const std::string& filePath, bool autosave = false);
+
+    bool PollResult(CheckpointResult& result);
+    void Flush();
+
+private:
+    struct Job
+    {
+        std::shared_ptr<const FieldSnapshot> snapshot;
+        std::string filePath;
+        bool autosave;
+    };
+
+    Task WriteJobs();
+
+    const size_t MAX_RESULTS = 64;
+    std::deque<Job> jobs;
+    std::deque<CheckpointResult> results;
+    std::mutex queueMutex;
+    std::condition_variable idle;
+    bool writing;
+
+    unsigned long long autosaveGenerations, lastAutosaveGeneration;
+    float autosaveSeconds;
+    std::string autosavePath;
+    std::chrono::steady_clock::time_point lastAutosaveTime;
+
+    TaskScheduler& scheduler;
+};
@@ -0,0 +1,209 @@
+#include "FieldFile.hpp"
+#include "MoviePlayer.hpp"
+#include "MovieRecorder.hpp"
+#include "PatternScript.hpp"
+#include "Simulation.hpp"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+// Headless runner, steps one field without a window.
+// Usage: gol_cli [--size WxH] [--load FILE] [--random N] [--bloody N] [--seed N]
+//                [--rule classic|bloody|table] [--table B3/S23] [--topology deadedge|torus]
+//                [--generations N] [--save FILE] [--record MOVIE] [--play MOVIE]
+//                [--patterns DIR] [--script FILE]
+// --play decodes a recorded movie up to generation N instead of simulating.
+// --script stamps patterns from DIR onto the loaded field, or onto an empty one.
+
+const unsigned int CLI_DEFAULT_WIDTH = 256;
+const unsigned int CLI_DEFAULT_HEIGHT = 256;
+const unsigned long long CLI_DEFAULT_RANDOM_CHANCE = 10ull;
+const unsigned long long CLI_DEFAULT_BLOODY_CHANCE = 500ull;
+const unsigned long long CLI_DEFAULT_GENERATIONS = 1000ull;
+const std::string CLI_DEFAULT_PATTERNS_PATH = "fields/patterns/";
+
+void PrintUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [--size WxH] [--load FILE] [--random N] [--bloody N] [--seed N]\n"
+        << "       [--rule classic|bloody|table] [--table B3/S23] [--topology deadedge|torus]\n"
+        << "       [--generations N] [--save FILE] [--record MOVIE] [--play MOVIE]\n"
+        << "       [--patterns DIR] [--script FILE]\n";
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned int width = CLI_DEFAULT_WIDTH, height = CLI_DEFAULT_HEIGHT;
+    unsigned long long randomChance = CLI_DEFAULT_RANDOM_CHANCE, randomChanceBloody = CLI_DEFAULT_BLOODY_CHANCE;
+    unsigned long long seed = (unsigned long long)time(nullptr), generations = CLI_DEFAULT_GENERATIONS;
+    std::string loadPath, savePath, recordPath, playPath, scriptPath, patternsPath = CLI_DEFAULT_PATTERNS_PATH;
+    CellRule rule = CellRule::Bloody;
+    TableRule table;
+    FieldTopology topology = FieldTopology::DeadEdge;
+
+    try
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string option = argv[i];
+            if (i + 1 >= argc)
+            {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            std::string value = argv[++i];
+
+            if (option == "--size")
+            {
+                if (!ParseSize(value, width, height))
+                {
+                    std::cerr << "Error: --size expects WxH, got " << value << "\n";
+                    return 1;
+                }
+            }
+            else if (option == "--load")
+                loadPath = value;
+            else if (option == "--save")
+                savePath = value;
+            else if (option == "--record")
+                recordPath = value;
+            else if (option == "--play")
+                playPath = value;
+            else if (option == "--patterns")
+                patternsPath = value;
+            else if (option == "--script")
+                scriptPath = value;
+            else if (option == "--random")
+                randomChance = std::max(1ull, std::stoull(value));
+            else if (option == "--bloody")
+                randomChanceBloody = std::stoull(value);
+            else if (option == "--seed")
+                seed = std::stoull(value);
+            else if (option == "--generations")
+                generations = std::stoull(value);
+            else if (option == "--rule" && (value == "classic" || value == "bloody" || value == "table"))
+                rule = value == "classic" ? CellRule::Classic : (value == "table" ? CellRule::Table : CellRule::Bloody);
+            else if (option == "--table" && TableRule::Parse(value, table))
+                rule = CellRule::Table;
+            else if (option == "--topology" && (value == "deadedge" || value == "torus"))
+                topology = value == "torus" ? FieldTopology::Torus : FieldTopology::DeadEdge;
+            else
+            {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception&)
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    MoviePlayer player;
+    if (playPath != "")
+    {
+        if (!player.Open(playPath))
+        {
+            std::cerr << "Error opening movie " << playPath << "\n";
+            return 1;
+        }
+        width = player.GetWidth();
+        height = player.GetHeight();
+    }
+
+    Simulation simulation(width, height, randomChance, randomChanceBloody);
+    simulation.SetRule(rule);
+    simulation.SetRuleTable(table.birth, table.survive);
+    simulation.SetTopology(topology);
+    simulation.Seed(seed);
+
+    if (loadPath != "")
+    {
+        if (!simulation.Load(loadPath))
+        {
+            std::cerr << "Error loading field " << loadPath << "\n";
+            return 1;
+        }
+    }
+    else if (scriptPath != "")
+        simulation.Clear();
+    else if (!player.IsOpen())
+        simulation.Randomize();
+
+    if (scriptPath != "")
+    {
+        PatternLibrary library;
+        library.LoadDirectory(patternsPath);
+
+        PatternScript script;
+        std::string error;
+        if (!script.Load(scriptPath, library, error))
+        {
+            std::cerr << "Error in script " << scriptPath << ": " << error << "\n";
+            return 1;
+        }
+
+        auto stampStart = std::chrono::steady_clock::now();
+        script.Apply(simulation);
+        std::chrono::duration<double> stampTime = std::chrono::steady_clock::now() - stampStart;
+        std::cout << "stamped " << script.GetPlacements().size() << " patterns in " << stampTime.count() * 1000.0 << " ms ("
+            << script.GetPlacements().size() / std::max(stampTime.count(), 1e-9) << " per second)\n";
+    }
+
+    // one worker is enough for the movie writer, stepping stays on this thread
+    TaskScheduler scheduler(1);
+    MovieRecorder recorder(scheduler);
+    if (recordPath != "")
+    {
+        if (!recorder.Start(recordPath, width, height))
+        {
+            std::cerr << "Error recording movie " << recordPath << "\n";
+            return 1;
+        }
+        recorder.AddFrame(simulation.TakeSnapshot());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (player.IsOpen())
+    {
+        player.Seek(generations);
+        simulation.LoadFrame(player.GetFrame(), player.GetGeneration());
+    }
+
+    while (!player.IsOpen() && simulation.GetGeneration() < generations && !simulation.IsStable())
+    {
+        simulation.NextGeneration();
+        if (recorder.IsRecording() && !simulation.IsStable())
+        {
+            recorder.AddFrame(simulation.TakeSnapshot());
+            recorder.BlockForRoom();
+        }
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "generation " << simulation.GetGeneration() << (simulation.IsStable() ? " (stable)" : "")
+        << ", alive " << simulation.CountCells(CELL_ALIVE) << ", bloody " << simulation.CountCells(CELL_BLOODY)
+        << ", hash " << std::hex << simulation.Hash() << std::dec
+        << ", " << elapsed.count() << " ms\n";
+
+    if (recorder.IsRecording())
+    {
+        if (!recorder.Stop())
+        {
+            std::cerr << "Error recording movie " << recordPath << "\n";
+            return 1;
+        }
+        unsigned long long textBytes = recorder.GetFrameCount() * ((unsigned long long)width + 1) * height;
+        std::cout << "recorded " << recorder.GetFrameCount() << " frames, " << recorder.GetBytesWritten()
+            << " bytes (" << textBytes << " bytes as text dumps)\n";
+    }
+
+    if (savePath != "" && !simulation.Save(savePath))
+    {
+        std::cerr << "Error saving field " << savePath << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include "DistributedRunner.hpp"
+#include "FieldFile.hpp"
+#include <algorithm>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+// Steps one large field split across several local processes.
+// Usage: gol_distributed [--size WxH] [--processes N] [--load FILE] [--random N] [--bloody N]
+//                        [--seed N] [--rule classic|bloody|table] [--table B3/S23]
+//                        [--topology deadedge|torus] [--generations N] [--save FILE]
+// Saves the same field as gol_cli given the same rule and options. The bloody rule needs --processes 1.
+
+const unsigned int DISTRIBUTED_DEFAULT_WIDTH = 4096;
+const unsigned int DISTRIBUTED_DEFAULT_HEIGHT = 4096;
+const unsigned int DISTRIBUTED_DEFAULT_PROCESSES = 4;
+const unsigned long long DISTRIBUTED_DEFAULT_RANDOM_CHANCE = 10ull;
+const unsigned long long DISTRIBUTED_DEFAULT_BLOODY_CHANCE = 500ull;
+const unsigned long long DISTRIBUTED_DEFAULT_GENERATIONS = 1000ull;
+
+void PrintUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [--size WxH] [--processes N] [--load FILE] [--random N] [--bloody N]\n"
+        << "       [--seed N] [--rule classic|bloody|table] [--table B3/S23]\n"
+        << "       [--topology deadedge|torus] [--generations N] [--save FILE]\n";
+}
+
+int main(int argc, char* argv[])
+{
+    DistributedSpec spec;
+    spec.width = DISTRIBUTED_DEFAULT_WIDTH;
+    spec.height = DISTRIBUTED_DEFAULT_HEIGHT;
+    spec.processCount = DISTRIBUTED_DEFAULT_PROCESSES;
+    spec.randomChance = DISTRIBUTED_DEFAULT_RANDOM_CHANCE;
+    spec.generations = DISTRIBUTED_DEFAULT_GENERATIONS;
+    spec.seed = (unsigned long long)time(nullptr);
+    spec.settings.rule = CellRule::Classic;
+    spec.settings.randomChanceBloody = DISTRIBUTED_DEFAULT_BLOODY_CHANCE;
+
+    try
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string option = argv[i];
+            if (i + 1 >= argc)
+            {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            std::string value = argv[++i];
+
+            if (option == "--size")
+            {
+                if (!ParseSize(value, spec.width, spec.height))
+                {
+                    std::cerr << "Error: --size expects WxH, got " << value << "\n";
+                    return 1;
+                }
+            }
+            else if (option == "--processes")
+                spec.processCount = std::max(1u, (unsigned int)std::stoul(value));
+            else if (option == "--load")
+                spec.loadPath = value;
+            else if (option == "--save")
+                spec.savePath = value;
+            else if (option == "--random")
+                spec.randomChance = std::max(1ull, std::stoull(value));
+            else if (option == "--bloody")
+                spec.settings.randomChanceBloody = std::stoull(value);
+            else if (option == "--seed")
+                spec.seed = std::stoull(value);
+            else if (option == "--generations")
+                spec.generations = std::stoull(value);
+            else if (option == "--rule" && (value == "classic" || value == "bloody" || value == "table"))
+                spec.settings.rule = value == "classic" ? CellRule::Classic : (value == "table" ? CellRule::Table : CellRule::Bloody);
+            else if (option == "--table" && TableRule::Parse(value, spec.settings.table))
+                spec.settings.rule = CellRule::Table;
+            else if (option == "--topology" && (value == "deadedge" || value == "torus"))
+                spec.settings.topology = value == "torus" ? FieldTopology::Torus : FieldTopology::DeadEdge;
+            else
+            {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception&)
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    DistributedRunner runner(spec);
+    DistributedResult result;
+    std::string error;
+    if (!runner.Run(result, error))
+    {
+        std::cerr << "Error: " << error << "\n";
+        return 1;
+    }
+
+    double cells = (double)spec.width * spec.height * spec.generations;
+    std::cout << "generation " << spec.generations << ", alive " << result.aliveCells << ", bloody " << result.bloodyCells
+        << ", " << result.stepMilliseconds << " ms stepping, " << result.waitMilliseconds << " ms waiting on halos ("
+        << cells / std::max(result.stepMilliseconds + result.waitMilliseconds, 1e-6) * 1000.0 << " cells per second, slowest process)\n";
+    return 0;
+}
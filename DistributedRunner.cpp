@@ -0,0 +1,333 @@
+#include "DistributedRunner.hpp"
+#include "FieldFile.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <utility>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+    const unsigned int NO_NEIGHBOUR = ~0u;
+    const unsigned int LEFT_EDGE = 0, RIGHT_EDGE = 1;
+    const unsigned int SPINS_BEFORE_YIELD = 64;
+
+    static_assert(std::atomic<unsigned long long>::is_always_lock_free, "the counters are shared between processes");
+
+    // Per process counter and results, each on its own cache line. The counter
+    // holds n + 1 once the edges of generation n are published.
+    struct StripSlot
+    {
+        alignas(64) std::atomic<unsigned long long> edgesReady;
+        unsigned long long aliveCells, bloodyCells;
+        double stepMilliseconds, waitMilliseconds;
+    };
+
+    double WaitFor(const std::atomic<unsigned long long>& counter, unsigned long long value)
+    {
+        if (counter.load(std::memory_order_acquire) >= value)
+            return 0.0;
+
+        // the neighbour is a busy process on another core, so spin a little before yielding
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int spin = 0; counter.load(std::memory_order_acquire) < value; spin++)
+        {
+            if (spin >= SPINS_BEFORE_YIELD)
+                std::this_thread::yield();
+        }
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Reads columns [begin, end) of grid from a text field file, column begin being
+    // field column firstColumn. Patterns are centred like DecodeFieldText() does,
+    // the file is streamed twice so it never has to fit in memory.
+    bool LoadStripColumns(const std::string& filePath, unsigned int fieldWidth, unsigned int firstColumn, PlaneGrid& grid, unsigned int begin, unsigned int end)
+    {
+        std::ifstream file(filePath, std::ios::binary);
+        if (filePath == "" || !file.is_open())
+            return false;
+
+        std::string line;
+        size_t patternWidth = 0, lineCount = 0;
+        while (std::getline(file, line))
+        {
+            patternWidth = std::max(patternWidth, line.size() - (!line.empty() && line.back() == '\r'));
+            lineCount++;
+        }
+
+        unsigned int height = grid.GetHeight();
+        unsigned int offsetX = patternWidth < fieldWidth ? (fieldWidth - (unsigned int)patternWidth) / 2 : 0;
+        unsigned int offsetY = lineCount < height ? (height - (unsigned int)lineCount) / 2 : 0;
+        size_t rows = std::min<size_t>(lineCount, height - offsetY);
+
+        file.clear();
+        file.seekg(0);
+        for (unsigned int row = 0; row < rows && std::getline(file, line); row++)
+        {
+            for (unsigned int x = begin; x < end; x++)
+            {
+                unsigned int fieldX = firstColumn + x - begin;
+                if (fieldX >= offsetX && fieldX - offsetX < line.size() && toupper(line[fieldX - offsetX]) == FILE_LIVING_CELL_CHAR)
+                    grid.Set(x, offsetY + row, CELL_ALIVE);
+            }
+        }
+        return true;
+    }
+
+    // writes columns [begin, end) of grid into their slice of every line of the field file
+    bool SaveStripColumns(const std::string& filePath, unsigned int fieldWidth, unsigned int firstColumn, const PlaneGrid& grid, unsigned int begin, unsigned int end)
+    {
+        int file = open(filePath.c_str(), O_WRONLY);
+        if (file < 0)
+            return false;
+
+        unsigned int columns = end - begin;
+        bool lastStrip = firstColumn + columns == fieldWidth;
+        std::string slice(columns + (lastStrip ? 1 : 0), '\n');
+        bool written = true;
+        for (unsigned int y = 0; y < grid.GetHeight() && written; y++)
+        {
+            for (unsigned int x = 0; x < columns; x++)
+                slice[x] = grid.Get(begin + x, y) != CELL_DEAD ? FILE_LIVING_CELL_CHAR : ' ';
+
+            off_t offset = (off_t)y * (fieldWidth + 1) + firstColumn;
+            written = pwrite(file, slice.data(), slice.size(), offset) == (ssize_t)slice.size();
+        }
+        return close(file) == 0 && written;
+    }
+}
+
+struct DistributedRunner::SharedState
+{
+    void* mapping;
+    size_t mappingSize;
+    StripSlot* slots;
+    uint64_t* edges;
+    size_t words;
+
+    // edge columns are double buffered by generation parity, a neighbour is at most one generation ahead
+    uint64_t* Edge(unsigned int strip, unsigned int parity, unsigned int side)
+    {
+        return edges + (((size_t)strip * 2 + parity) * 2 + side) * words;
+    }
+};
+
+DistributedRunner::DistributedRunner(const DistributedSpec& spec)
+    : spec(spec), wordsPerColumn(((size_t)spec.height + 63) / 64)
+{
+    unsigned int processCount = std::max(1u, std::min(spec.processCount, spec.width));
+    for (unsigned int i = 0; i < processCount; i++)
+        strips.push_back(Strip{ (unsigned int)((unsigned long long)spec.width * i / processCount), (unsigned int)((unsigned long long)spec.width * (i + 1) / processCount) });
+}
+
+bool DistributedRunner::Run(DistributedResult& result, std::string& error)
+{
+    if (spec.width == 0 || spec.height == 0)
+    {
+        error = "empty field";
+        return false;
+    }
+    if (spec.settings.rule == CellRule::Bloody && strips.size() > 1)
+    {
+        error = "the bloody rule runs on one process only";
+        return false;
+    }
+
+    // everything the processes share lives in one anonymous mapping created before the fork
+    unsigned int count = (unsigned int)strips.size();
+    size_t slotBytes = (sizeof(StripSlot) * count + 63) / 64 * 64;
+    size_t edgeWords = (size_t)count * 2 * 2 * wordsPerColumn;
+
+    SharedState shared;
+    shared.mappingSize = slotBytes + edgeWords * sizeof(uint64_t);
+    shared.mapping = mmap(nullptr, shared.mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared.mapping == MAP_FAILED)
+    {
+        error = "can't map shared memory";
+        return false;
+    }
+    shared.slots = static_cast<StripSlot*>(shared.mapping);
+    for (unsigned int i = 0; i < count; i++)
+        new (&shared.slots[i]) StripSlot{ {0}, 0, 0, 0.0, 0.0 };
+    shared.edges = reinterpret_cast<uint64_t*>(static_cast<char*>(shared.mapping) + slotBytes);
+    shared.words = wordsPerColumn;
+
+    // the strips write their slices straight into a file of the final size, renamed when all succeeded
+    std::string temporaryPath = spec.savePath + ".tmp";
+    if (spec.savePath != "")
+    {
+        int file = open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        bool created = file >= 0 && ftruncate(file, (off_t)(spec.width + 1) * spec.height) == 0;
+        if (file >= 0)
+            close(file);
+        if (!created)
+        {
+            munmap(shared.mapping, shared.mappingSize);
+            error = "can't create " + spec.savePath;
+            return false;
+        }
+    }
+
+    // buffered output would be written once per process otherwise
+    std::cout.flush();
+    std::cerr.flush();
+
+    std::vector<pid_t> processes;
+    bool failed = false;
+    for (unsigned int i = 0; i < count && !failed; i++)
+    {
+        pid_t process = fork();
+        if (process == 0)
+            _exit(RunStrip(shared, i));
+        if (process < 0)
+        {
+            error = "can't fork";
+            failed = true;
+        }
+        else
+            processes.push_back(process);
+    }
+
+    // a failed process would leave its neighbours waiting forever, so the rest are stopped
+    size_t running = processes.size();
+    while (running > 0)
+    {
+        int status = 0;
+        pid_t process = wait(&status);
+        if (process < 0)
+            break;
+        running--;
+
+        if (!failed && (!WIFEXITED(status) || WEXITSTATUS(status) != 0))
+        {
+            error = "process " + std::to_string(std::find(processes.begin(), processes.end(), process) - processes.begin()) + " failed";
+            failed = true;
+        }
+        if (failed)
+        {
+            for (pid_t other : processes)
+                kill(other, SIGKILL);
+        }
+    }
+
+    result = DistributedResult();
+    for (unsigned int i = 0; i < count; i++)
+    {
+        result.aliveCells += shared.slots[i].aliveCells;
+        result.bloodyCells += shared.slots[i].bloodyCells;
+        result.stepMilliseconds = std::max(result.stepMilliseconds, shared.slots[i].stepMilliseconds);
+        result.waitMilliseconds = std::max(result.waitMilliseconds, shared.slots[i].waitMilliseconds);
+    }
+    munmap(shared.mapping, shared.mappingSize);
+
+    if (spec.savePath != "")
+    {
+        if (failed || std::rename(temporaryPath.c_str(), spec.savePath.c_str()) != 0)
+        {
+            std::remove(temporaryPath.c_str());
+            if (!failed)
+                error = "can't save " + spec.savePath;
+            return false;
+        }
+    }
+    return !failed;
+}
+
+int DistributedRunner::RunStrip(SharedState& shared, unsigned int index)
+{
+    unsigned int count = (unsigned int)strips.size();
+    bool torus = spec.settings.topology == FieldTopology::Torus;
+    unsigned int left = count == 1 ? NO_NEIGHBOUR : (index > 0 ? index - 1 : (torus ? count - 1 : NO_NEIGHBOUR));
+    unsigned int right = count == 1 ? NO_NEIGHBOUR : (index + 1 < count ? index + 1 : (torus ? 0 : NO_NEIGHBOUR));
+
+    // Local columns [begin, end) are the strip, begin - 1 and end the halos. A single
+    // strip is the whole field, it needs no halos and wraps or stops at its own edges
+    // like a Simulation. Dead edges need no halo either, the grids' guard columns are dead.
+    unsigned int columns = strips[index].end - strips[index].begin;
+    unsigned int begin = count == 1 ? 0 : 1, end = begin + columns;
+    PlaneGrid current(columns + 2 * begin, spec.height), next(columns + 2 * begin, spec.height);
+    size_t words = current.GetWordsPerColumn();
+
+    // strip 0 draws the same random numbers as a Simulation seeded the same way
+    Randomizer randomizer;
+    randomizer.Seed(spec.seed + index);
+    if (spec.loadPath == "")
+    {
+        Randomizer soup;
+        soup.Seed(spec.seed);
+        FillRandomColumns(current, begin, end, strips[index].begin, soup.Random<uint64_t>(0, UINT64_MAX), spec.randomChance);
+        randomizer.Random<uint64_t>(0, UINT64_MAX);
+    }
+    else if (!LoadStripColumns(spec.loadPath, spec.width, strips[index].begin, current, begin, end))
+        return 1;
+
+    StripSlot& slot = shared.slots[index];
+    double waitMilliseconds = 0.0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (unsigned long long generation = 0; generation < spec.generations; generation++)
+    {
+        unsigned int parity = (unsigned int)(generation & 1);
+
+        if (spec.settings.rule == CellRule::Bloody)
+        {
+            // one strip only, see Run()
+            next.CopyFrom(current);
+            StepColumns(spec.settings, randomizer, current, next, begin, end);
+            std::swap(current, next);
+            continue;
+        }
+
+        // publish the strip's edge columns of this generation, two-state rules only read the alive plane
+        std::copy(current.AliveColumn(begin), current.AliveColumn(begin) + words, shared.Edge(index, parity, LEFT_EDGE));
+        std::copy(current.AliveColumn(end - 1), current.AliveColumn(end - 1) + words, shared.Edge(index, parity, RIGHT_EDGE));
+        slot.edgesReady.store(generation + 1, std::memory_order_release);
+
+        // the interior needs no halo, so it is stepped while the neighbours' edges arrive
+        if (columns > 2)
+            StepColumns(spec.settings, randomizer, current, next, begin + 1, end - 1);
+        if (left != NO_NEIGHBOUR)
+        {
+            waitMilliseconds += WaitFor(shared.slots[left].edgesReady, generation + 1);
+            std::copy(shared.Edge(left, parity, RIGHT_EDGE), shared.Edge(left, parity, RIGHT_EDGE) + words, current.AliveColumn(begin - 1));
+        }
+        if (right != NO_NEIGHBOUR)
+        {
+            waitMilliseconds += WaitFor(shared.slots[right].edgesReady, generation + 1);
+            std::copy(shared.Edge(right, parity, LEFT_EDGE), shared.Edge(right, parity, LEFT_EDGE) + words, current.AliveColumn(end));
+        }
+        StepColumns(spec.settings, randomizer, current, next, begin, begin + 1);
+        if (columns > 1)
+            StepColumns(spec.settings, randomizer, current, next, end - 1, end);
+        std::swap(current, next);
+    }
+
+    unsigned long long aliveCells = 0, bloodyCells = 0;
+    for (unsigned int x = begin; x < end; x++)
+    {
+        for (size_t i = 0; i < words; i++)
+        {
+            aliveCells += PopCount(current.AliveColumn(x)[i]);
+            bloodyCells += PopCount(current.BloodyColumn(x)[i]);
+        }
+    }
+
+    slot.aliveCells = aliveCells;
+    slot.bloodyCells = bloodyCells;
+    slot.waitMilliseconds = waitMilliseconds;
+    slot.stepMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() - waitMilliseconds;
+
+    if (spec.savePath != "" && !SaveStripColumns(spec.savePath + ".tmp", spec.width, strips[index].begin, current, begin, end))
+        return 1;
+    return 0;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Simulation.hpp"
+#include <string>
+#include <vector>
+
+
+// One field split into vertical strips, one forked process per strip. A process
+// only allocates its own columns plus a halo column on each side, so the whole
+// field never has to fit in one address space. Neighbouring strips swap their
+// edge columns every generation through a shared memory mapping.
+//
+// Two-state rules give the same field as a single Simulation for any number of
+// processes; the interior of a strip is stepped while the neighbours' edges are
+// still on their way. The bloody rule updates the field in place in scan order
+// with one random stream, which strips can't split, so it runs on one process only.
+struct DistributedSpec
+{
+    unsigned int width = 4096, height = 4096;
+    unsigned int processCount = 4;
+    unsigned long long generations = 1000;
+    unsigned long long seed = 1;
+    unsigned long long randomChance = 10;
+    StepSettings settings;
+    // empty for a random soup, otherwise a text field file
+    std::string loadPath;
+    // the strips are written straight into one text field file when set
+    std::string savePath;
+};
+
+struct DistributedResult
+{
+    unsigned long long aliveCells = 0, bloodyCells = 0;
+    // slowest process, stepping and halo waits only
+    double stepMilliseconds = 0.0;
+    double waitMilliseconds = 0.0;
+};
+
+class DistributedRunner
+{
+public:
+    explicit DistributedRunner(const DistributedSpec& spec);
+
+    // forks the processes and waits for all of them, false with a message if any
+    // failed or the bloody rule was given more than one process
+    bool Run(DistributedResult& result, std::string& error);
+
+private:
+    struct Strip
+    {
+        unsigned int begin, end;
+    };
+
+    struct SharedState;
+
+    // body of one forked process, returns its exit code
+    int RunStrip(SharedState& shared, unsigned int index);
+
+    DistributedSpec spec;
+    std::vector<Strip> strips;
+    size_t wordsPerColumn;
+};
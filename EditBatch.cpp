@@ -0,0 +1,75 @@
+#include "EditBatch.hpp"
+#include <cstdlib>
+
+
+void EditBatch::SetCell(int x, int y, uint8_t state)
+{
+    edits.push_back(Edit{ EditType::Cell, x, y, CellRect(), state, false, nullptr });
+}
+
+void EditBatch::DrawLine(int x0, int y0, int x1, int y1, uint8_t state)
+{
+    // Bresenham, so a fast drag still leaves a connected line
+    int dx = std::abs(x1 - x0), dy = -std::abs(y1 - y0);
+    int stepX = x0 < x1 ? 1 : -1, stepY = y0 < y1 ? 1 : -1;
+    int error = dx + dy;
+    while (true)
+    {
+        SetCell(x0, y0, state);
+        if (x0 == x1 && y0 == y1)
+            break;
+
+        int doubled = 2 * error;
+        if (doubled >= dy)
+        {
+            error += dy;
+            x0 += stepX;
+        }
+        if (doubled <= dx)
+        {
+            error += dx;
+            y0 += stepY;
+        }
+    }
+}
+
+void EditBatch::Fill(const CellRect& rect, uint8_t state)
+{
+    edits.push_back(Edit{ EditType::Fill, 0, 0, rect, state, false, nullptr });
+}
+
+void EditBatch::Paste(const PatternStamp& stamp, int x, int y, bool replace)
+{
+    edits.push_back(Edit{ EditType::Paste, x, y, CellRect(), CELL_ALIVE, replace, &stamp });
+}
+
+bool EditBatch::IsEmpty() const
+{
+    return edits.empty();
+}
+
+CellRect EditBatch::Apply(Simulation& simulation)
+{
+    CellRect dirty;
+    for (const Edit& edit : edits)
+    {
+        switch (edit.type)
+        {
+            case EditType::Cell:
+                if (edit.x >= 0 && edit.y >= 0 && (unsigned int)edit.x < simulation.GetWidth() && (unsigned int)edit.y < simulation.GetHeight())
+                {
+                    simulation.SetCell((unsigned int)edit.x, (unsigned int)edit.y, edit.state);
+                    dirty.Include(CellRect{ (unsigned int)edit.x, (unsigned int)edit.y, 1, 1 });
+                }
+                break;
+            case EditType::Fill:
+                dirty.Include(simulation.Fill(edit.rect, edit.state));
+                break;
+            case EditType::Paste:
+                dirty.Include(simulation.Stamp(*edit.stamp, edit.x, edit.y, edit.replace));
+                break;
+        }
+    }
+    edits.clear();
+    return dirty;
+}
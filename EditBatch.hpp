@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Simulation.hpp"
+#include <vector>
+
+
+// Edits collected from input between two frames. They are applied in one go,
+// so the field is locked once per frame and only the touched cells are redrawn.
+class EditBatch
+{
+public:
+    void SetCell(int x, int y, uint8_t state);
+    // every cell on the line from x0, y0 to x1, y1, both ends included
+    void DrawLine(int x0, int y0, int x1, int y1, uint8_t state);
+    void Fill(const CellRect& rect, uint8_t state);
+    // the stamp has to stay alive until Apply()
+    void Paste(const PatternStamp& stamp, int x, int y, bool replace);
+
+    bool IsEmpty() const;
+    // applies the edits in order and empties the batch, returns the bounding box of the touched cells
+    CellRect Apply(Simulation& simulation);
+
+private:
+    enum class EditType
+    {
+        Cell,
+        Fill,
+        Paste
+    };
+
+    struct Edit
+    {
+        EditType type;
+        int x, y;
+        CellRect rect;
+        uint8_t state;
+        bool replace;
+        const PatternStamp* stamp;
+    };
+
+    std::vector<Edit> edits;
+};
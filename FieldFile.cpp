@@ -0,0 +1,145 @@
+#include "FieldFile.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+
+bool ParseSize(const std::string& text, unsigned int& width, unsigned int& height)
+{
+    // strtoull skips blanks and takes signs, so both numbers have to start with a digit
+    size_t separator = text.find_first_of("xX");
+    if(separator == std::string::npos || !isdigit((unsigned char)text[0]) || !isdigit((unsigned char)text[separator + 1]))
+        return false;
+
+    char* end = nullptr;
+    unsigned long long parsedWidth = strtoull(text.c_str(), &end, 10);
+    if(end != text.c_str() + separator)
+        return false;
+    unsigned long long parsedHeight = strtoull(text.c_str() + separator + 1, &end, 10);
+    if(*end != '\0' || parsedWidth > UINT32_MAX || parsedHeight > UINT32_MAX)
+        return false;
+
+    width = (unsigned int)parsedWidth;
+    height = (unsigned int)parsedHeight;
+    return true;
+}
+
+bool ReadFileText(const std::string& filePath, std::string& text)
+{
+    if(filePath == "" || !std::filesystem::exists(filePath))
+        return false;
+
+    std::ifstream file(filePath, std::ios::binary);
+    if(!file.is_open())
+        return false;
+
+    text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+void DecodeFieldText(const std::string& text, PlaneGrid& grid)
+{
+    // offset and length of every line, the cells are parsed in parallel below
+    std::vector<std::pair<size_t, size_t>> lines;
+    size_t patternWidth = 0;
+    for (size_t start = 0; start < text.size();)
+    {
+        size_t end = text.find('\n', start);
+        if (end == std::string::npos)
+            end = text.size();
+
+        size_t length = end - start;
+        if (length > 0 && text[end - 1] == '\r')
+            length--;
+
+        lines.push_back(std::make_pair(start, length));
+        patternWidth = std::max(patternWidth, length);
+        start = end + 1;
+    }
+
+    // patterns that fit are centred, larger ones are clipped from the top left corner
+    unsigned int width = grid.GetWidth();
+    unsigned int height = grid.GetHeight();
+    unsigned int offsetX = patternWidth < width ? (width - (unsigned int)patternWidth) / 2 : 0;
+    unsigned int offsetY = lines.size() < height ? (height - (unsigned int)lines.size()) / 2 : 0;
+    unsigned int rows = (unsigned int)std::min<size_t>(lines.size(), height - offsetY);
+
+    ParallelFor(0, width, [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int x = begin; x < end; x++)
+        {
+            uint64_t* alive = grid.AliveColumn(x);
+            uint64_t* bloody = grid.BloodyColumn(x);
+            std::fill(alive, alive + grid.GetWordsPerColumn(), 0);
+            std::fill(bloody, bloody + grid.GetWordsPerColumn(), 0);
+
+            if (x < offsetX)
+                continue;
+
+            size_t x2 = x - offsetX;
+            for (unsigned int y2 = 0; y2 < rows; y2++)
+            {
+                unsigned int y = offsetY + y2;
+                if (x2 < lines[y2].second && toupper(text[lines[y2].first + x2]) == FILE_LIVING_CELL_CHAR)
+                    alive[y >> 6] |= 1ull << (y & 63);
+            }
+        }
+    }, ColumnsPerChunk(height));
+}
+
+std::string EncodeFieldText(const PlaneGrid& grid)
+{
+    unsigned int width = grid.GetWidth();
+    unsigned int height = grid.GetHeight();
+    size_t lineLength = (size_t)width + 1;
+    std::string text(lineLength * height, ' ');
+
+    // rows own disjoint slices of the buffer
+    ParallelFor(0, height, [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int y = begin; y < end; y++)
+        {
+            char* line = &text[y * lineLength];
+            for (unsigned int x = 0; x < width; x++)
+            {
+                if (grid.Get(x, y) != CELL_DEAD)
+                    line[x] = FILE_LIVING_CELL_CHAR;
+            }
+            line[width] = '\n';
+        }
+    }, ColumnsPerChunk(width));
+    return text;
+}
+
+bool WriteFileAtomically(const std::string& filePath, const std::string& data)
+{
+    if(filePath == "")
+        return false;
+
+    std::string temporaryPath = filePath + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if(!file.is_open())
+            return false;
+        file.write(data.data(), (std::streamsize)data.size());
+        file.close();
+        if(file.fail())
+            return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, filePath, error);
+    if(error)
+    {
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    return true;
+}
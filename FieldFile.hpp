@@ -0,0 +1,21 @@
+#pragma once
+
+#include "CellGrid.hpp"
+#include <string>
+
+// Text field files hold one line per row, FILE_LIVING_CELL_CHAR marks alive cells
+
+const char FILE_LIVING_CELL_CHAR = 'X';
+
+bool ReadFileText(const std::string& filePath, std::string& text);
+
+// Parses "WxH" as given on the command lines and in manifests, false on a missing
+// separator or anything else than digits around it. Zero sizes are left to the caller.
+bool ParseSize(const std::string& text, unsigned int& width, unsigned int& height);
+
+// Patterns that fit are centred, larger ones are clipped from the top left corner
+void DecodeFieldText(const std::string& text, PlaneGrid& grid);
+std::string EncodeFieldText(const PlaneGrid& grid);
+
+// Writes next to the target and renames over it, readers never see a half written file
+bool WriteFileAtomically(const std::string& filePath, const std::string& data);
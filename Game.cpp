@@ -1,8 +1,28 @@
 #include "Game.hpp"
-
-Game::Game(unsigned int resX, unsigned int resY, unsigned int maxFPS, unsigned long long randomChance, unsigned long long randomChanceBloody, float cellSize, float cellGap, const sf::Color& aliveCellColor, const sf::Color& bloodyCellColor, const sf::Color& deadCellColor, const sf::Color& hoveredCellColor, const sf::Color& backgroundColor)
-    : backgroundColor(backgroundColor)
+#include <algorithm>
+#include <cmath>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <iostream>
+#endif
+
+Game::Game(unsigned int resX, unsigned int resY, unsigned int fieldWidth, unsigned int fieldHeight, unsigned int maxFPS, unsigned long long randomChance, unsigned long long randomChanceBloody, float cellSize, float cellGap, const sf::Color& aliveCellColor, const sf::Color& bloodyCellColor, const sf::Color& deadCellColor, const sf::Color& hoveredCellColor, const sf::Color& backgroundColor, unsigned long long autosaveGenerations, float autosaveSeconds)
+    : backgroundColor(backgroundColor), simulationGate(scheduler), checkpointWriter(scheduler), movieRecorder(scheduler),
+      selectedPattern(0), patternOrientation(0), painting(false), selecting(false), paintState(CELL_ALIVE), shownGeneration(0), shownStable(false), movieTextDirty(false), autosaveFailed(false)
 {
+    // the field is allocated and filled on a worker while the window and the font are set up
+    // the field draws with the pitch rounded to whole pixels
+    float cellPitch = std::max(1.f, std::round(cellSize + cellGap));
+    if(fieldWidth == 0)
+        fieldWidth = (unsigned int)(resX / cellPitch);
+    if(fieldHeight == 0)
+        fieldHeight = (unsigned int)((resY > GAMEFIELD_HEIGHT_OFFSET ? resY - GAMEFIELD_HEIGHT_OFFSET : 0) / cellPitch);
+    std::promise<Simulation> fieldReady;
+    std::future<Simulation> field = fieldReady.get_future();
+    scheduler.Spawn(PrepareField(std::move(fieldReady), std::max(1u, fieldWidth), std::max(1u, fieldHeight), randomChance, randomChanceBloody));
+
     gameWindow = std::make_unique<sf::RenderWindow>(sf::VideoMode(resX, resY), GAME_TITLE, sf::Style::Close);
     SetMaxFPS(maxFPS);
 
@@ -11,7 +31,13 @@ Game::Game(unsigned int resX, unsigned int resY, unsigned int maxFPS, unsigned l
     simulationDelay = 50;
     paused = true;
 
-    gameField = std::make_unique<GameField>((unsigned int)(gameWindow->getSize().x / (cellSize + cellGap)), (unsigned int)((gameWindow->getSize().y - GAMEFIELD_HEIGHT_OFFSET) / (cellSize + cellGap)), sf::Vector2f(0, (float)GAMEFIELD_HEIGHT_OFFSET), randomChance, randomChanceBloody, cellSize, cellGap, aliveCellColor, bloodyCellColor, deadCellColor, hoveredCellColor);
+    checkpointWriter.SetAutosave(autosaveGenerations, autosaveSeconds, FIELDS_PATH + AUTOSAVE_FILE);
+
+    // every orientation is precomputed here, clicks only blit
+    patternLibrary.LoadDirectory(FIELDS_PATH + PATTERNS_PATH);
+    selectedPattern = patternLibrary.GetCount();
+
+    gameField = std::make_unique<GameField>(field.get(), sf::Vector2f(0, (float)GAMEFIELD_HEIGHT_OFFSET), cellSize, cellGap, aliveCellColor, bloodyCellColor, deadCellColor, hoveredCellColor, backgroundColor);
 
     escapeText.setFont(gameFont);
     escapeText.setString("ESC to exit");
@@ -45,7 +71,7 @@ Game::Game(unsigned int resX, unsigned int resY, unsigned int maxFPS, unsigned l
     delayText.setPosition(gameWindow->getSize().x / 2 - delayText.getGlobalBounds().width / 2 - TEXT_MARGIN, 0);
 
     delayVarText.setFont(gameFont);
-	delayVarText.setString("Simulation delay: " + std::to_string(simulationDelay) + "ms");
+	delayVarText.setString("Simulation delay: " + std::to_string(simulationDelay.load()) + "ms");
     delayVarText.setCharacterSize(CHARACTER_SIZE);
     delayVarText.setPosition(gameWindow->getSize().x / 2 - delayVarText.getGlobalBounds().width / 2 - TEXT_MARGIN, (float)CHARACTER_SIZE);
 
@@ -84,13 +110,22 @@ Game::Game(unsigned int resX, unsigned int resY, unsigned int maxFPS, unsigned l
     openSaveText.setString("O/S to open/save field from/to file");
     openSaveText.setCharacterSize(CHARACTER_SIZE);
     openSaveText.setPosition(gameWindow->getSize().x - pauseText.getGlobalBounds().width - TEXT_MARGIN, (float)CHARACTER_SIZE * 3);
+
+    movieText.setFont(gameFont);
+    movieText.setCharacterSize(CHARACTER_SIZE);
+    UpdateMovieText();
+
+    patternText.setFont(gameFont);
+    patternText.setCharacterSize(CHARACTER_SIZE);
+    patternText.setPosition(TEXT_MARGIN, (float)CHARACTER_SIZE * 4);
+    UpdatePatternText();
 }
 
 Game::~Game()
 {
-    paused = true;
-    sf::sleep(sf::milliseconds(1));
-    simulationThread.detach();
+    // the stepping task leaves its gate or delay and finishes, queued saves and frames are written
+    scheduler.Stop();
+    movieRecorder.Stop();
 
     if(gameWindow != nullptr)
     {
@@ -101,14 +136,13 @@ Game::~Game()
 
 void Game::Run()
 {   
-    RandomizeField();
-    simulationThread = std::thread(&Game::simulationTask, this);
+    scheduler.Spawn(SimulationTask());
+    // the frame limit paces the loop
     while(gameWindow->isOpen())
     {
         HandleInput();
         Tick();
         Render();
-        sf::sleep(sf::milliseconds(1));
     }
 }
 
@@ -119,11 +153,15 @@ void Game::HandleInput()
     while(gameWindow->pollEvent(event))
     {   
         if (event.type == sf::Event::MouseMoved)
-            gameField->SetLocalMousePosition(sf::Vector2u(event.mouseMove.x, event.mouseMove.y));
+            MouseMoved(sf::Vector2u(event.mouseMove.x, event.mouseMove.y));
         else if (event.type == sf::Event::MouseButtonPressed)
-            gameField->MouseClicked();
+            MousePressed(event.mouseButton.button);
+        else if (event.type == sf::Event::MouseButtonReleased)
+            MouseReleased();
         else if(event.type == sf::Event::Closed)
             gameWindow->close();
+        else if(event.type == sf::Event::KeyPressed && (event.key.control || event.key.code == sf::Keyboard::Delete))
+            HandleEditKey(event.key.code);
         else if(event.type == sf::Event::KeyPressed)
         {
             switch(event.key.code)
@@ -139,7 +177,14 @@ void Game::HandleInput()
                     break;
                 case sf::Keyboard::N:
 					if (paused)
-						NextGeneration();
+					{
+						{
+							std::lock_guard<std::mutex> lock(lockMutex);
+							NextGeneration();
+						}
+						// holding N must not outrun the movie writer either
+						movieRecorder.BlockForRoom();
+					}
                     break;
                 case sf::Keyboard::Up:
                     IncreaseDelay();
@@ -162,6 +207,24 @@ void Game::HandleInput()
                 case sf::Keyboard::C:
                     ClearField();
                     break;
+                case sf::Keyboard::M:
+                    ToggleRecording();
+                    break;
+                case sf::Keyboard::V:
+                    TogglePlayback();
+                    break;
+                case sf::Keyboard::Tab:
+                    SelectNextPattern();
+                    break;
+                case sf::Keyboard::Q:
+                    TurnPattern(false);
+                    break;
+                case sf::Keyboard::E:
+                    TurnPattern(true);
+                    break;
+                case sf::Keyboard::F:
+                    MirrorPattern();
+                    break;
             }
         }
     }
@@ -169,6 +232,34 @@ void Game::HandleInput()
 
 void Game::Tick()
 {
+    ApplyEdits();
+
+    // only the upload happens here, the changed cells go to a worker and show up a frame later
+    {
+        std::lock_guard<std::mutex> lock(lockMutex);
+        gameField->UploadTexture();
+        CellRect changed = gameField->BeginPrepare();
+        if(!changed.IsEmpty())
+            scheduler.Spawn(PrepareTexture(changed));
+        UpdateGenerationText();
+        if(movieTextDirty)
+            UpdateMovieText();
+    }
+
+    CheckpointResult checkpoint;
+    while (checkpointWriter.PollResult(checkpoint))
+    {
+        // a failing autosave is reported once, not on every later attempt
+        if (checkpoint.autosave && !checkpoint.success && autosaveFailed)
+            continue;
+        if (checkpoint.autosave)
+            autosaveFailed = !checkpoint.success;
+        if (!checkpoint.success && checkpoint.autosave)
+            ShowError("Error autosaving field to " + checkpoint.filePath + ", further autosave errors are not shown until one succeeds");
+        else if (!checkpoint.success)
+            ShowError("Error saving field to " + checkpoint.filePath);
+    }
+
     if (gameField->IsHoveredOnCell())
     {
         sf::Vector2u hoveredCellCoords = gameField->GetHoveredCellCoords();
@@ -195,6 +286,8 @@ void Game::Render()
     gameWindow->draw(pauseText);
     gameWindow->draw(pauseVarText);
     gameWindow->draw(openSaveText);
+    gameWindow->draw(movieText);
+    gameWindow->draw(patternText);
 
     gameWindow->draw(*gameField);
 
@@ -204,6 +297,11 @@ void Game::Render()
 void Game::ToggleGameState()
 {
     paused = !paused;
+    if(paused)
+        simulationGate.Close();
+    else
+        simulationGate.Open();
+
     sf::String stateString = paused ? "Paused" : "Playing";
     pauseVarText.setString("State: " + stateString);
     pauseVarText.setPosition(gameWindow->getSize().x - pauseText.getGlobalBounds().width - TEXT_MARGIN, (float)CHARACTER_SIZE * 2);
@@ -211,14 +309,14 @@ void Game::ToggleGameState()
 
 void Game::RandomizeField()
 {
+    std::lock_guard<std::mutex> lock(lockMutex);
     gameField->Randomize();
-    generationVarText.setString("Generation: 0");
 }
 
 void Game::IncreaseDelay()
 {
     simulationDelay++;
-    delayVarText.setString("Simulation delay: " + std::to_string(simulationDelay) + "ms");
+    delayVarText.setString("Simulation delay: " + std::to_string(simulationDelay.load()) + "ms");
     delayVarText.setPosition(gameWindow->getSize().x / 2 - delayVarText.getGlobalBounds().width / 2 - TEXT_MARGIN, (float)CHARACTER_SIZE);
 }
 
@@ -227,7 +325,7 @@ void Game::DecreaseDelay()
     if(simulationDelay > 0)
         simulationDelay--;
 
-    delayVarText.setString("Simulation delay: " + std::to_string(simulationDelay) + "ms");
+    delayVarText.setString("Simulation delay: " + std::to_string(simulationDelay.load()) + "ms");
     delayVarText.setPosition(gameWindow->getSize().x / 2 - delayVarText.getGlobalBounds().width / 2 - TEXT_MARGIN, (float)CHARACTER_SIZE);
 }
 
@@ -261,17 +359,20 @@ void Game::SetMaxFPS(unsigned int maxFPS)
 
 void Game::NextGeneration()
 {
-    if(!gameField->IsStable())
+    if(moviePlayer.IsOpen())
+        PlayNextFrame();
+    else if(!gameField->IsStable())
     {
         gameField->NextGeneration();
-		generationVarText.setString("Generation: " + std::to_string(gameField->GetGeneration()));
+        checkpointWriter.OnGeneration(gameField->GetSimulation());
+        if(movieRecorder.IsRecording())
+            movieRecorder.AddFrame(gameField->GetSimulation().TakeSnapshot());
     }
-    else
-        generationVarText.setString("Generation: " + std::to_string(gameField->GetGeneration()) + "(stable)");
 }
 
 const std::string Game::OpenFileDialog(bool save) const
 {
+#ifdef _WIN32
     OPENFILENAME ofn = { sizeof(ofn)};
 
     char fileName[MAX_PATH] = "";
@@ -282,7 +383,7 @@ const std::string Game::OpenFileDialog(bool save) const
     ofn.nMaxFile = MAX_PATH;
     ofn.lpstrFilter = "All (*.*)\0*.*\0Text (*.txt)\0*.txt\0Game of Life (*.gol)\0*.gol\0";
     ofn.nFilterIndex = 1;
-    std::string initialDir = R"(.\)" + FIELDS_PATH;
+    std::string initialDir = "./" + FIELDS_PATH;
     ofn.lpstrInitialDir = initialDir.c_str();
     if(save)
         ofn.lpstrTitle = "Save Game of Life field";
@@ -297,40 +398,338 @@ const std::string Game::OpenFileDialog(bool save) const
         GetOpenFileName(&ofn);
 
     return fileName;
+#else
+    std::cout << (save ? "Save Game of Life field to: " : "Open Game of Life field: ") << std::flush;
+    std::string fileName;
+    std::getline(std::cin, fileName);
+    return fileName;
+#endif
+}
+
+void Game::ShowError(const std::string& message) const
+{
+#ifdef _WIN32
+    MessageBoxA(gameWindow->getSystemHandle(), message.c_str(), "Game of life error", 0);
+#else
+    std::cerr << "Game of life error: " << message << std::endl;
+#endif
 }
 
 void Game::LoadField()
 {
     std::string filePath = OpenFileDialog(false);
 
+    std::lock_guard<std::mutex> lock(lockMutex);
     if(!gameField->Load(filePath))
-        MessageBoxA(gameWindow->getSystemHandle(), "Error loading field or loading canceled", "Game of life error", 0);
+        ShowError("Error loading field or loading canceled");
 }
 
 void Game::SaveField()
 {
     std::string filePath = OpenFileDialog(true);
 
-    if(!gameField->Save(filePath))
-        MessageBoxA(gameWindow->getSystemHandle(), "Error saving field or saving canceled", "Game of life error", 0);
+    if(filePath == "")
+    {
+        ShowError("Error saving field or saving canceled");
+        return;
+    }
+
+    // the copy is taken between two generations, encoding and writing happen on the I/O thread
+    std::shared_ptr<const FieldSnapshot> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(lockMutex);
+        snapshot = gameField->GetSimulation().TakeSnapshot();
+    }
+    checkpointWriter.Submit(snapshot, filePath);
 }
 
 void Game::ClearField()
 {
+    std::lock_guard<std::mutex> lock(lockMutex);
     gameField->Clear();
 }
 
-void Game::simulationTask()
+void Game::ToggleRecording()
 {
-    while(true)
+    bool stopRecording;
     {
-        while(!paused)
+        std::lock_guard<std::mutex> lock(lockMutex);
+        stopRecording = movieRecorder.IsRecording();
+        if(stopRecording)
+            movieRecorder.EndRecording();
+    }
+
+    // the writing task may need the worker of a task waiting for the field lock, so it is not held here
+    if(stopRecording)
+    {
+        if(!movieRecorder.Stop())
+            ShowError("Error writing movie");
+        std::lock_guard<std::mutex> lock(lockMutex);
+        UpdateMovieText();
+        return;
+    }
+
+    std::string filePath = OpenFileDialog(true);
+
+    std::lock_guard<std::mutex> lock(lockMutex);
+    if(moviePlayer.IsOpen() || !movieRecorder.Start(filePath, gameField->GetSize().x, gameField->GetSize().y))
+    {
+        ShowError("Error recording movie or recording canceled");
+        return;
+    }
+
+    // the first frame is the field as it is now, every generation after it is appended
+    movieRecorder.AddFrame(gameField->GetSimulation().TakeSnapshot());
+    UpdateMovieText();
+}
+
+void Game::TogglePlayback()
+{
+    {
+        std::lock_guard<std::mutex> lock(lockMutex);
+        if(moviePlayer.IsOpen())
         {
-            lockMutex.lock();
-            sf::sleep(sf::milliseconds(simulationDelay));
+            moviePlayer.Close();
+            UpdateMovieText();
+            return;
+        }
+    }
+
+    std::string filePath = OpenFileDialog(false);
+
+    std::lock_guard<std::mutex> lock(lockMutex);
+    if(movieRecorder.IsRecording() || !moviePlayer.Open(filePath))
+    {
+        ShowError("Error opening movie or opening canceled");
+        return;
+    }
+
+    gameField->ShowFrame(moviePlayer.GetFrame(), moviePlayer.GetGeneration());
+    UpdateMovieText();
+}
+
+void Game::PlayNextFrame()
+{
+    // frames come from the file, the field is only redrawn
+    if(moviePlayer.NextFrame())
+        gameField->ShowFrame(moviePlayer.GetFrame(), moviePlayer.GetGeneration());
+    else
+    {
+        moviePlayer.Close();
+        movieTextDirty = true;
+    }
+}
+
+void Game::UpdateMovieText()
+{
+    if(movieRecorder.IsRecording())
+        movieText.setString("Recording movie, M to stop");
+    else if(moviePlayer.IsOpen())
+        movieText.setString("Playing movie, V to stop");
+    else
+        movieText.setString("M/V to record/play movie");
+    movieText.setPosition(gameWindow->getSize().x - pauseText.getGlobalBounds().width - TEXT_MARGIN, (float)CHARACTER_SIZE * 4);
+    movieTextDirty = false;
+}
+
+void Game::UpdateGenerationText()
+{
+    // rebuilt only when the stepping task got further
+    unsigned long long generation = gameField->GetGeneration();
+    bool stable = gameField->IsStable();
+    if(generation == shownGeneration && stable == shownStable)
+        return;
+
+    shownGeneration = generation;
+    shownStable = stable;
+    generationVarText.setString("Generation: " + std::to_string(generation) + (stable ? "(stable)" : ""));
+}
+
+void Game::MousePressed(sf::Mouse::Button button)
+{
+    if(!gameField->IsHoveredOnCell())
+        return;
+
+    sf::Vector2u cell = gameField->GetHoveredCellCoords();
+    bool shift = sf::Keyboard::isKeyPressed(sf::Keyboard::LShift) || sf::Keyboard::isKeyPressed(sf::Keyboard::RShift);
+    if(button == sf::Mouse::Left && shift)
+    {
+        selecting = true;
+        dragStart = cell;
+        selection = CellRect{ cell.x, cell.y, 1, 1 };
+        gameField->SetSelection(selection);
+        UpdatePatternText();
+    }
+    else if(button == sf::Mouse::Left && selectedPattern < patternLibrary.GetCount())
+        editBatch.Paste(patternLibrary.GetStamp(selectedPattern, patternOrientation), (int)cell.x, (int)cell.y, false);
+    else if(button == sf::Mouse::Left || button == sf::Mouse::Right)
+    {
+        // left paints, or erases when the drag starts on an alive cell, right always erases
+        paintState = CELL_DEAD;
+        if(button == sf::Mouse::Left)
+        {
+            std::lock_guard<std::mutex> lock(lockMutex);
+            paintState = gameField->GetSimulation().GetCell(cell.x, cell.y) ? CELL_DEAD : CELL_ALIVE;
+        }
+        painting = true;
+        lastDragCell = cell;
+        editBatch.SetCell((int)cell.x, (int)cell.y, paintState);
+    }
+}
+
+void Game::MouseMoved(const sf::Vector2u& mousePosition)
+{
+    gameField->SetLocalMousePosition(mousePosition);
+    if(!gameField->IsHoveredOnCell())
+        return;
+
+    sf::Vector2u cell = gameField->GetHoveredCellCoords();
+    if(painting && cell != lastDragCell)
+    {
+        editBatch.DrawLine((int)lastDragCell.x, (int)lastDragCell.y, (int)cell.x, (int)cell.y, paintState);
+        lastDragCell = cell;
+    }
+    else if(selecting)
+    {
+        unsigned int left = std::min(dragStart.x, cell.x), top = std::min(dragStart.y, cell.y);
+        selection = CellRect{ left, top, std::max(dragStart.x, cell.x) - left + 1, std::max(dragStart.y, cell.y) - top + 1 };
+        gameField->SetSelection(selection);
+        UpdatePatternText();
+    }
+}
+
+void Game::MouseReleased()
+{
+    painting = false;
+    selecting = false;
+}
+
+void Game::HandleEditKey(sf::Keyboard::Key key)
+{
+    switch(key)
+    {
+        case sf::Keyboard::C:
+        case sf::Keyboard::X:
+            if(selection.IsEmpty())
+                break;
+            {
+                // earlier edits of this frame have to be in the copy
+                ApplyEdits();
+                std::lock_guard<std::mutex> lock(lockMutex);
+                clipboard = gameField->GetSimulation().Copy(selection);
+            }
+            if(key == sf::Keyboard::X)
+                editBatch.Fill(selection, CELL_DEAD);
+            break;
+        case sf::Keyboard::V:
+            if(gameField->IsHoveredOnCell() && clipboard.width > 0)
+                editBatch.Paste(clipboard, (int)gameField->GetHoveredCellCoords().x, (int)gameField->GetHoveredCellCoords().y, true);
+            break;
+        case sf::Keyboard::F:
+            editBatch.Fill(selection, CELL_ALIVE);
+            break;
+        case sf::Keyboard::Delete:
+            editBatch.Fill(selection, CELL_DEAD);
+            break;
+        case sf::Keyboard::D:
+            selection = CellRect();
+            gameField->SetSelection(selection);
+            UpdatePatternText();
+            break;
+        default:
+            break;
+    }
+}
+
+void Game::ApplyEdits()
+{
+    // one lock and one texture refresh per frame however many cells were painted
+    if(editBatch.IsEmpty())
+        return;
+
+    std::lock_guard<std::mutex> lock(lockMutex);
+    gameField->ApplyEdits(editBatch);
+}
+
+void Game::SelectNextPattern()
+{
+    selectedPattern = selectedPattern < patternLibrary.GetCount() ? selectedPattern + 1 : 0;
+    UpdatePatternText();
+}
+
+void Game::TurnPattern(bool clockwise)
+{
+    patternOrientation = (patternOrientation & PATTERN_MIRROR) | ((patternOrientation + (clockwise ? 1 : 3)) & 3);
+    UpdatePatternText();
+}
+
+void Game::MirrorPattern()
+{
+    patternOrientation ^= PATTERN_MIRROR;
+    UpdatePatternText();
+}
+
+void Game::UpdatePatternText()
+{
+    if(!selection.IsEmpty())
+        patternText.setString("Selection " + std::to_string(selection.width) + "x" + std::to_string(selection.height) + ", CTRL+C/X/V/F/D to copy/cut/paste/fill/deselect, DEL to clear");
+    else if(selectedPattern < patternLibrary.GetCount())
+        patternText.setString("Pattern: " + patternLibrary.GetName(selectedPattern) + ", TAB/Q/E/F to change/turn/mirror");
+    else
+        patternText.setString("Drag/right drag to paint/erase, SHIFT drag to select" + std::string(patternLibrary.GetCount() > 0 ? ", TAB for patterns" : ""));
+
+    gameField->SetCursorPattern(selectedPattern < patternLibrary.GetCount() ? &patternLibrary.GetStamp(selectedPattern, patternOrientation) : nullptr);
+}
+
+Task Game::PrepareField(std::promise<Simulation> fieldReady, unsigned int width, unsigned int height, unsigned long long randomChance, unsigned long long randomChanceBloody)
+{
+    // the first fill is the only full pass, the first frame converts it to pixels
+    try
+    {
+        Simulation simulation(width, height, randomChance, randomChanceBloody);
+        uint64_t seed = simulation.BeginRandomize();
+        co_await scheduler.ParallelFor(0, width, [&](unsigned int begin, unsigned int end)
+        {
+            simulation.RandomizeColumns(begin, end, seed);
+        }, ColumnsPerChunk(height));
+        fieldReady.set_value(std::move(simulation));
+    }
+    catch(...)
+    {
+        fieldReady.set_exception(std::current_exception());
+    }
+}
+
+Task Game::SimulationTask()
+{
+    while(!scheduler.IsStopping())
+    {
+        // paused, the task is parked and holds no worker
+        co_await simulationGate.Wait();
+        co_await scheduler.Delay(std::chrono::milliseconds(simulationDelay.load()));
+        if(!simulationGate.IsOpen() || scheduler.IsStopping())
+            continue;
+
+        {
+            std::lock_guard<std::mutex> lock(lockMutex);
             NextGeneration();
-            lockMutex.unlock();
         }
-        sf::sleep(sf::milliseconds(10));
+
+        // a full movie queue parks the task here, the field stays unlocked meanwhile
+        co_await movieRecorder.WaitForRoom();
+        // a zero delay doesn't suspend, this lets the render thread take the lock between generations
+        co_await scheduler.Schedule();
     }
+}
+
+Task Game::PrepareTexture(CellRect rect)
+{
+    // reads the copy BeginPrepare() took, the field lock is only needed to hand the pixels over
+    co_await scheduler.ParallelFor(rect.y >> 6, ((rect.y + rect.height - 1) >> 6) + 1, [&](unsigned int begin, unsigned int end)
+    {
+        gameField->PrepareRows(rect, begin, end);
+    }, ColumnsPerChunk(rect.width * 64));
+
+    std::lock_guard<std::mutex> lock(lockMutex);
+    gameField->FinishPrepare(rect);
 }
\ No newline at end of file
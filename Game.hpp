@@ -2,11 +2,16 @@
 
 #include "SFML.hpp"
 #include "GameField.hpp"
-#include <windows.h>
+#include "CheckpointWriter.hpp"
+#include "MoviePlayer.hpp"
+#include "MovieRecorder.hpp"
+#include "Pattern.hpp"
+#include "TaskScheduler.hpp"
+#include <atomic>
+#include <future>
 #include <memory>
 #include <sstream>
 #include <iomanip>
-#include <thread>
 #include <mutex>
 
 
@@ -14,7 +19,8 @@
 class Game
 {
 public:
-    Game(unsigned int resX, unsigned int resY, unsigned int maxFPS,unsigned long long randomChance, unsigned long long randomChanceBloody, float cellSize, float cellGap, const sf::Color& aliveCellColor, const sf::Color& bloodyCellColor, const sf::Color& deadCellColor, const sf::Color& hoveredCellColor, const sf::Color& backgroundColor);
+    // a field size of 0 fits the field to the window
+    Game(unsigned int resX, unsigned int resY, unsigned int fieldWidth, unsigned int fieldHeight, unsigned int maxFPS,unsigned long long randomChance, unsigned long long randomChanceBloody, float cellSize, float cellGap, const sf::Color& aliveCellColor, const sf::Color& bloodyCellColor, const sf::Color& deadCellColor, const sf::Color& hoveredCellColor, const sf::Color& backgroundColor, unsigned long long autosaveGenerations, float autosaveSeconds);
 	Game(Game const &) = delete;
 	void operator=(Game) = delete;
 	~Game();
@@ -34,15 +40,32 @@ protected:
     const std::string GetRandomChancePercentage() const;
     void SetMaxFPS(unsigned int maxFPS);
     void NextGeneration();
-    const std::string Game::OpenFileDialog(bool save) const;
+    const std::string OpenFileDialog(bool save) const;
+    void ShowError(const std::string& message) const;
     void LoadField();
     void SaveField();
     void ClearField();
+    void ToggleRecording();
+    void TogglePlayback();
+    void PlayNextFrame();
+    void UpdateMovieText();
+    void UpdateGenerationText();
+    void MousePressed(sf::Mouse::Button button);
+    void MouseMoved(const sf::Vector2u& mousePosition);
+    void MouseReleased();
+    void HandleEditKey(sf::Keyboard::Key key);
+    void ApplyEdits();
+    void SelectNextPattern();
+    void TurnPattern(bool clockwise);
+    void MirrorPattern();
+    void UpdatePatternText();
 
 private:
-	const sf::String CONTENT_PATH = R"(content\)";
-    const sf::String FIELDS_PATH = R"(fields\)";
+	const sf::String CONTENT_PATH = "content/";
+    const sf::String FIELDS_PATH = "fields/";
+    const sf::String PATTERNS_PATH = "patterns/";
     const sf::String FONT_FILE = "MainFont.ttf";
+    const sf::String AUTOSAVE_FILE = "autosave.txt";
     const sf::String GAME_TITLE = "Game of Life";
     const float TEXT_MARGIN = 10.f;
     const unsigned int CHARACTER_SIZE = 15u;
@@ -52,16 +75,42 @@ private:
     std::unique_ptr <GameField> gameField;
 
     bool paused;
-    unsigned int simulationDelay;
+    std::atomic<unsigned int> simulationDelay;
     sf::Vector2i localMousePosition;
     
     sf::Font gameFont;
-    sf::Text escapeText, nextGenerationText, generationVarText, hoveredCellCoordsVarText, delayText, delayVarText, randomChanceText, randomChanceVarText, clearText, randomizeText, pauseText, pauseVarText, openSaveText;
+    sf::Text escapeText, nextGenerationText, generationVarText, hoveredCellCoordsVarText, delayText, delayVarText, randomChanceText, randomChanceVarText, clearText, randomizeText, pauseText, pauseVarText, openSaveText, movieText, patternText;
 
 
     sf::Color backgroundColor;
 
-    std::thread simulationThread;
+    // stepping and file writes run as tasks, the gate is open while playing
+    TaskScheduler scheduler;
+    PauseGate simulationGate;
+    CheckpointWriter checkpointWriter;
+    MovieRecorder movieRecorder;
+    MoviePlayer moviePlayer;
+    // selectedPattern == patternLibrary.GetCount() means single cells
+    PatternLibrary patternLibrary;
+    size_t selectedPattern;
+    unsigned int patternOrientation;
+
+    // mouse edits wait here until the next frame, see ApplyEdits()
+    EditBatch editBatch;
+    PatternStamp clipboard;
+    CellRect selection;
+    sf::Vector2u dragStart, lastDragCell;
+    bool painting, selecting;
+    uint8_t paintState;
+
+    // shown by the render thread, the stepping task only changes the field
+    unsigned long long shownGeneration;
+    bool shownStable, movieTextDirty;
+    // set after an autosave failed until one succeeds
+    bool autosaveFailed;
+
     std::mutex lockMutex;
-    void simulationTask();
+    Task SimulationTask();
+    Task PrepareTexture(CellRect rect);
+    Task PrepareField(std::promise<Simulation> fieldReady, unsigned int width, unsigned int height, unsigned long long randomChance, unsigned long long randomChanceBloody);
 };
\ No newline at end of file
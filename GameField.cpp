@@ -1,30 +1,40 @@
 #include "GameField.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
 
 
-GameField::GameField(unsigned int fieldWidth, unsigned int fieldHeight, const sf::Vector2f& fieldPosition, unsigned long long randomChance, unsigned long long randomChanceBloody, float cellSize, float cellGap, const sf::Color& aliveCellColor, const sf::Color& bloodyCellColor, const sf::Color& deadCellColor, const sf::Color& hoveredCellColor)
-    : position(fieldPosition), randomChance(randomChance), randomChanceBloody(randomChanceBloody), cellSize(cellSize), cellGap(cellGap), aliveCellColor(aliveCellColor), bloodyCellColor(bloodyCellColor), deadCellColor(deadCellColor)
+GameField::GameField(Simulation&& fieldSimulation, const sf::Vector2f& fieldPosition, float cellSize, float cellGap, const sf::Color& aliveCellColor, const sf::Color& bloodyCellColor, const sf::Color& deadCellColor, const sf::Color& hoveredCellColor, const sf::Color& gapColor)
+    : simulation(std::move(fieldSimulation)), preparing(false), position(fieldPosition), cellSize(cellSize), cellGap(cellGap), aliveCellColor(aliveCellColor), bloodyCellColor(bloodyCellColor), deadCellColor(deadCellColor), gapColor(gapColor), cursorPattern(nullptr)
 {
-    gameField = std::vector<std::vector<unsigned int>> (fieldWidth, std::vector<unsigned int>(fieldHeight));
-
-    if(cellSize > 1.f)
-        verticles = sf::VertexArray(sf::PrimitiveType::Quads, fieldWidth * fieldHeight * 4);
-    else
-        verticles = sf::VertexArray(sf::PrimitiveType::Points, fieldWidth * fieldHeight);
+    // fields past the texture limit are cut at the bottom right, that part is off screen anyway
+    textureSize = sf::Vector2u(std::min(simulation.GetWidth(), sf::Texture::getMaximumSize()), std::min(simulation.GetHeight(), sf::Texture::getMaximumSize()));
+    cellTexture.create(textureSize.x, textureSize.y);
+    cellSprite.setTexture(cellTexture, true);
+    pixels.resize((size_t)textureSize.x * textureSize.y);
+    shownField = PlaneGrid(textureSize.x, textureSize.y);
     
-    cellSizeAndGap = cellSize + cellGap;
-    hoveredCellRect = sf::RectangleShape(sf::Vector2f(cellSize, cellSize));
+    UpdatePitch();
     hoveredCellRect.setFillColor(hoveredCellColor);
-    generation = 0;
-    stable = false;
+    hoveredOnCell = false;
 
-    randomizer.Seed((unsigned long long)time(nullptr));
+    selectionRect.setFillColor(sf::Color::Transparent);
+    selectionRect.setOutlineColor(hoveredCellColor);
+    selectionRect.setOutlineThickness(1.f);
 
-    UpdateVerticles();
+    UpdateCursor();
+    UpdateLayout();
+    MarkDirty();
 }
 
 void GameField::draw(sf::RenderTarget& target, sf::RenderStates states) const
 {
-    target.draw(verticles, states);
+    target.draw(cellSprite, states);
+    if(cellGap > 0.f)
+        target.draw(gapSprite, states);
+
+    if(!selection.IsEmpty())
+        target.draw(selectionRect, states);
 
     if(hoveredOnCell)
     {
@@ -35,6 +45,7 @@ void GameField::draw(sf::RenderTarget& target, sf::RenderStates states) const
 void GameField::SetPosition(const sf::Vector2f& position)
 {
     this->position = position;
+    UpdateLayout();
 }
 
 const sf::Vector2f& GameField::GetPosition() const 
@@ -44,87 +55,20 @@ const sf::Vector2f& GameField::GetPosition() const
 
 const sf::Vector2u GameField::GetSize() const 
 {
-    if(gameField.size() > 0)
-        return sf::Vector2u((unsigned int)gameField.size(), (unsigned int)gameField[0].size());
-    
-    return sf::Vector2u(0, 0);
+    return sf::Vector2u(simulation.GetWidth(), simulation.GetHeight());
 }
 
 void GameField::Randomize()
 {
-    sf::Vector2u gameFieldSize = GetSize();
-	this->Clear();
-
-    for (unsigned int x = 0; x < gameFieldSize.x; x++)
-    {
-        for (unsigned int y = 0; y < gameFieldSize.y; y++)
-        {
-            bool alive = randomizer.Random<unsigned long long>(1, randomChance) == 1;
-            if (alive)
-				gameField[x][y] = 1;
-			/* enable for bloody cell randomization
-			bool bloody = randomizer.Random<unsigned long long>(1, randomChance * 20) == 1;
-			if (bloody)
-				gameField[x][y] = 2;
-			*/
-        }
-    }
-
-    generation = 0;
-    stable = false;
-    UpdateVerticles();
+    simulation.Randomize();
+    MarkDirty();
 }
 
 bool GameField::Load(const std::string& filePath) 
 {
-    if(filePath != "" && std::experimental::filesystem::exists(filePath))
+    if(simulation.Load(filePath))
     {
-        std::vector<std::vector<unsigned int>> values;
-        std::ifstream file(filePath);
-        std::string line = "";
-
-        while (std::getline(file, line))
-        {
-            std::vector<unsigned int> valueLine;
-
-            for (const auto& value : line)
-                valueLine.push_back(toupper(value) == FILE_LIVING_CELL_CHAR);
-            
-            values.push_back(valueLine);
-        }
-
-        for (unsigned int x = 0; x < gameField.size(); x++)
-        {
-            for (unsigned int y = 0; y < gameField[0].size(); y++)
-            {
-                gameField[x][y] = false;
-            }
-        }
-        
-        if(values.size() < gameField.size() && values[0].size() < gameField[0].size())
-        {
-            for(unsigned int x = (unsigned int)gameField.size() / 2 - (unsigned int)values[0].size(), x2 = 0; x < (unsigned int)gameField.size(), x2 < (unsigned int)values[0].size(); x++, x2++)
-            {
-                for(unsigned int y = (unsigned int)gameField[0].size() / 2 - (unsigned int)values.size(), y2 = 0; y < (unsigned int)gameField[0].size(), y2 < (unsigned int)values.size(); y++, y2++)
-                {
-                    gameField[x][y] = values[x2][y2];
-                }
-            }
-        }
-        else
-        {
-            for (unsigned int y = 0; y < gameField[0].size(); y++)
-            {
-                for (unsigned int x = 0; x < gameField.size(); x++)
-                {
-                    gameField[x][y] = values[y][x];
-                }
-            }
-        }
-
-        generation = 0;
-        stable = false;
-        UpdateVerticles();
+        MarkDirty();
         return true;
     }
     return false;
@@ -132,98 +76,33 @@ bool GameField::Load(const std::string& filePath)
 
 bool GameField::Save(const std::string& filePath) const
 {
-    if(filePath != "")
-    {
-        std::ofstream file(filePath);
-
-        for (unsigned int y = 0; y < gameField[0].size(); y++)
-        {
-            for (unsigned int x = 0; x < gameField.size(); x++)
-            {
-                file << (gameField[x][y] ? "X" : " ");
-            }
-            file << "\n";
-        }
-        file.close();
-        return true;
-    }
-    return false;
+    return simulation.Save(filePath);
 }
 
 void GameField::Clear()
 {
-    for (auto &column : gameField)
-        std::fill(column.begin(), column.end(), 0);
-
-    generation = 0;
-    stable = false;
-    UpdateVerticles();
+    simulation.Clear();
+    MarkDirty();
 }
 
 void GameField::NextGeneration()
 {
-    if(!stable)
-    {
-        bool changed = false;
-        std::vector<std::vector<unsigned int>> tempField(gameField);
-		
-        for (unsigned int x = 0; x < tempField.size(); x++)
-        {
-            for (unsigned int y = 0; y < tempField[0].size(); y++)
-            {
-                int aliveNeighboursCount = GetAliveNeighboursCount(tempField, x, y);
-				//bloody cell movement
-				if (gameField[x][y] == 2)
-				{
-					std::pair<unsigned int, unsigned int> moveCoords = SearchForPrey(tempField, x, y);
-					if (gameField[moveCoords.first][moveCoords.second] == 1)
-					{
-						gameField[moveCoords.first][moveCoords.second] = 2;
-						changed = true;
-					}
-					else if (gameField[moveCoords.first][moveCoords.second] == 0)
-					{
-						gameField[x][y] = 0;
-						changed = true;
-					}
-				}
-				//green cell generation
-                if(gameField[x][y] == 1 && (aliveNeighboursCount < 2 || aliveNeighboursCount > 3))
-                {
-                    gameField[x][y] = 0;
-                    changed = true;
-                }
-                else if (gameField[x][y] == 0 && aliveNeighboursCount == 3)
-                {
-                    gameField[x][y] = 1;
-                    changed = true;
-                }
-				//bloody cell generation
-				else if (gameField[x][y] == 1 && aliveNeighboursCount >= 2)
-				{
-					if (randomizer.Random<unsigned long long>(1, randomChanceBloody) == 1)
-					{
-						gameField[x][y] = 2;
-						changed = true;
-					}
-				}
-            }
-        }
-        stable = !changed;
-        if(!stable)
-        {
-            generation++;
-            UpdateVerticles();
-        }
-    }
+    if(simulation.NextGeneration())
+        MarkDirty();
+}
+
+void GameField::ShowFrame(const PlaneGrid& frame, unsigned long long generation)
+{
+    simulation.LoadFrame(frame, generation);
+    MarkDirty();
 }
 
 void GameField::SetCellSize(float cellSize)
 {
     this->cellSize = cellSize;
-    cellSizeAndGap = cellSize + cellGap;
-    hoveredCellRect.setSize(sf::Vector2f(cellSize, cellSize));
-    UpdateVerticles();
+    UpdatePitch();
+    UpdateCursor();
+    UpdateLayout();
 }
 
 float GameField::GetCellSize() const
@@ -234,8 +113,9 @@ float GameField::GetCellSize() const
 void GameField::SetCellGap(float cellGap)
 {
     this->cellGap = cellGap;
-    cellSizeAndGap = cellSize + cellGap;
-    UpdateVerticles();
+    UpdatePitch();
+    UpdateCursor();
+    UpdateLayout();
 }
 
 float GameField::GetCellGap() const
@@ -248,8 +128,8 @@ void GameField::SetLocalMousePosition(const sf::Vector2u& localMousePosition)
     unsigned int relX = (unsigned int)(localMousePosition.x - position.x);
     unsigned int relY = (unsigned int)(localMousePosition.y - position.y);
     
-    unsigned int fieldSizeX = (unsigned int)(gameField.size() * cellSizeAndGap);
-    unsigned int fieldSizeY = (unsigned int)(gameField[0].size() * cellSizeAndGap);
+    unsigned int fieldSizeX = (unsigned int)(simulation.GetWidth() * cellSizeAndGap);
+    unsigned int fieldSizeY = (unsigned int)(simulation.GetHeight() * cellSizeAndGap);
 
     hoveredOnCell = false;
     if(relX < fieldSizeX && relX >= 0 && relY < fieldSizeY && relY >= 0)
@@ -263,35 +143,69 @@ void GameField::SetLocalMousePosition(const sf::Vector2u& localMousePosition)
     }
 }
 
-void GameField::MouseClicked()
+void GameField::SetCursorPattern(const PatternStamp* cursorPattern)
 {
+    this->cursorPattern = cursorPattern;
+    UpdateCursor();
     if(hoveredOnCell)
-    {
-        gameField[hoveredCellCoords.x][hoveredCellCoords.y] = !gameField[hoveredCellCoords.x][hoveredCellCoords.y];
-        stable = false;
-        UpdateVerticles();
-    }
+        hoveredCellRect.setPosition(hoveredCellCoords.x * cellSizeAndGap + position.x, hoveredCellCoords.y * cellSizeAndGap + position.y);
+}
+
+void GameField::SetSelection(const CellRect& selection)
+{
+    this->selection = selection;
+    UpdateSelection();
+}
+
+void GameField::ApplyEdits(EditBatch& batch)
+{
+    MarkDirty(batch.Apply(simulation));
 }
 
 unsigned long long GameField::GetGeneration() const 
 {
-    return generation;
+    return simulation.GetGeneration();
 }
 
 void GameField::SetRandomChance(unsigned long long randomChance)
 {
-    this->randomChance = randomChance;
+    simulation.SetRandomChance(randomChance);
 }
 
 unsigned long long GameField::GetRandomChance() const
 {
-    return randomChance;
+    return simulation.GetRandomChance();
+}
+
+void GameField::SetRule(CellRule rule)
+{
+    simulation.SetRule(rule);
+}
+
+CellRule GameField::GetRule() const
+{
+    return simulation.GetRule();
+}
+
+void GameField::SetRuleTable(uint16_t birth, uint16_t survive)
+{
+    simulation.SetRuleTable(birth, survive);
+}
+
+void GameField::SetTopology(FieldTopology topology)
+{
+    simulation.SetTopology(topology);
+}
+
+FieldTopology GameField::GetTopology() const
+{
+    return simulation.GetTopology();
 }
 
 void GameField::SetAliveCellColor(const sf::Color& aliveCellColor)
 {
     this->aliveCellColor = aliveCellColor;
-    UpdateVerticles();
+    MarkDirty();
 }
 
 const sf::Color& GameField::GetAliveCellColor() const
@@ -302,7 +216,7 @@ const sf::Color& GameField::GetAliveCellColor() const
 void GameField::SetBloodyCellColor(const sf::Color& bloodyCellColor)
 {
 	this->bloodyCellColor = bloodyCellColor;
-	UpdateVerticles();
+	MarkDirty();
 }
 
 const sf::Color& GameField::GetBloodyCellColor() const
@@ -313,7 +227,7 @@ const sf::Color& GameField::GetBloodyCellColor() const
 void GameField::SetDeadCellColor(const sf::Color& deadCellColor)
 {
     this->deadCellColor = deadCellColor;
-    UpdateVerticles();
+    MarkDirty();
 }
 
 const sf::Color& GameField::GetDeadCellColor() const
@@ -343,97 +257,145 @@ const sf::Vector2u& GameField::GetHoveredCellCoords() const
 
 bool GameField::IsStable() const
 {
-    return stable;
+    return simulation.IsStable();
 }
 
-unsigned int GameField::GetAliveNeighboursCount(const  std::vector<std::vector<unsigned int>>& field, unsigned int x, unsigned int y) const
+Simulation& GameField::GetSimulation()
 {
-    int aliveNeighbours = 0;
-	int neighbourOffsets[8][2] = { {-1,-1}, {0,-1}, {1,-1}, {-1,0}, {1,0}, {-1,1}, {0,1}, {1,1} };
+    return simulation;
+}
 
-    for(const auto& currentOffset : neighbourOffsets)
-    {
-        int xToCheck = x + currentOffset[0];
-        int yToCheck = y + currentOffset[1];
+const Simulation& GameField::GetSimulation() const
+{
+    return simulation;
+}
 
-        if(xToCheck >= 0 && yToCheck >= 0 && xToCheck < field.size() && yToCheck < field[0].size())
+void GameField::UpdatePitch()
+{
+    // the sprite scale and the gap tile share one whole pixel pitch, so the grid lines stay on the cells
+    cellSizeAndGap = std::max(1.f, std::round(cellSize + cellGap));
+}
+
+void GameField::UpdateLayout()
+{
+    cellSprite.setPosition(position);
+    cellSprite.setScale(cellSizeAndGap, cellSizeAndGap);
+    UpdateSelection();
+
+    // one cell pitch: the cell itself is transparent, the gap right and below it is painted
+    unsigned int tileSize = (unsigned int)cellSizeAndGap;
+    std::vector<sf::Color> tile((size_t)tileSize * tileSize, sf::Color::Transparent);
+    for (unsigned int y = 0; y < tileSize; y++)
+    {
+        for (unsigned int x = 0; x < tileSize; x++)
         {
-            if(field[xToCheck][yToCheck] == 1)
-                aliveNeighbours++;
+            if (x >= cellSize || y >= cellSize)
+                tile[(size_t)y * tileSize + x] = gapColor;
         }
     }
-    return aliveNeighbours;
+
+    gapTexture.create(tileSize, tileSize);
+    gapTexture.update((const sf::Uint8*)tile.data());
+    gapTexture.setRepeated(true);
+    gapSprite.setTexture(gapTexture);
+    gapSprite.setTextureRect(sf::IntRect(0, 0, (int)(textureSize.x * tileSize), (int)(textureSize.y * tileSize)));
+    gapSprite.setPosition(position);
 }
-//Bloody Cell Behaviour function:
-std::pair<unsigned int, unsigned int> GameField::SearchForPrey(const  std::vector<std::vector<unsigned int>>& field, unsigned int x, unsigned int y) 
+
+void GameField::UpdateCursor()
 {
-	int neighbourOffsets[8][2] = { { -1,-1 },{ 0,-1 },{ 1,-1 },{ -1,0 },{ 1,0 },{ -1,1 },{ 0,1 },{ 1,1 } };
+    // the cursor covers the whole pattern, without the gap after its last cell
+    sf::Vector2u cells = cursorPattern != nullptr ? sf::Vector2u(cursorPattern->width, cursorPattern->height) : sf::Vector2u(1, 1);
+    hoveredCellRect.setSize(sf::Vector2f(cells.x * cellSizeAndGap - cellGap, cells.y * cellSizeAndGap - cellGap));
+}
 
-	for (const auto& currentOffset : neighbourOffsets)
-	{
-		int xToCheck = x + currentOffset[0];
-		int yToCheck = y + currentOffset[1];
+void GameField::UpdateSelection()
+{
+    // the outline is drawn inside the selected cells
+    selectionRect.setPosition(position.x + selection.x * cellSizeAndGap + 1.f, position.y + selection.y * cellSizeAndGap + 1.f);
+    selectionRect.setSize(sf::Vector2f(std::max(0.f, selection.width * cellSizeAndGap - cellGap - 2.f), std::max(0.f, selection.height * cellSizeAndGap - cellGap - 2.f)));
+}
 
-		if (xToCheck >= 0 && yToCheck >= 0 && xToCheck < field.size() && yToCheck < field[0].size())
-		{
-			if (field[xToCheck][yToCheck] == 1)
-				return std::make_pair(xToCheck, yToCheck);
-		}
-	}
-	int randomMoveOffset = randomizer.Random<unsigned long long>(1, 8);
-	int xToMove = x + neighbourOffsets[randomMoveOffset][0];
-	int yToMove = y + neighbourOffsets[randomMoveOffset][1];
-	if (xToMove >= 0 && yToMove >= 0 && xToMove < field.size() && yToMove < field[0].size())
-		return std::make_pair(xToMove, yToMove);
-	else
-		return std::make_pair(x, y);
+void GameField::MarkDirty()
+{
+    MarkDirty(CellRect{ 0, 0, textureSize.x, textureSize.y });
 }
 
+void GameField::MarkDirty(const CellRect& rect)
+{
+    // fields past the texture limit are cut, see the constructor
+    unsigned int right = std::min(rect.x + rect.width, textureSize.x), bottom = std::min(rect.y + rect.height, textureSize.y);
+    if (!rect.IsEmpty() && rect.x < right && rect.y < bottom)
+        dirtyRect.Include(CellRect{ rect.x, rect.y, right - rect.x, bottom - rect.y });
+}
 
-void GameField::UpdateVerticles()
+CellRect GameField::BeginPrepare()
 {
-    size_t i = 0;
+    if (preparing || dirtyRect.IsEmpty() || !preparedRect.IsEmpty())
+        return CellRect();
 
-    for (unsigned int x = 0; x < gameField.size(); x++)
+    // whole words are copied, the conversion reads the rows of the rect from them
+    const PlaneGrid& gameField = simulation.GetGrid();
+    unsigned int firstWord = dirtyRect.y >> 6, lastWord = (dirtyRect.y + dirtyRect.height - 1) >> 6;
+    for (unsigned int x = dirtyRect.x; x < dirtyRect.x + dirtyRect.width; x++)
     {
-        for (unsigned int y = 0; y < gameField[0].size(); y++)
-        {
-            float curPosX = position.x + x * cellSizeAndGap;
-            float curPosY = position.y + y * cellSizeAndGap;
+        std::copy(gameField.AliveColumn(x) + firstWord, gameField.AliveColumn(x) + lastWord + 1, shownField.AliveColumn(x) + firstWord);
+        std::copy(gameField.BloodyColumn(x) + firstWord, gameField.BloodyColumn(x) + lastWord + 1, shownField.BloodyColumn(x) + firstWord);
+    }
+
+    CellRect rect = dirtyRect;
+    dirtyRect = CellRect();
+    preparing = true;
+    return rect;
+}
+
+void GameField::PrepareRows(const CellRect& rect, unsigned int wordBegin, unsigned int wordEnd)
+{
+    static_assert(sizeof(sf::Color) == 4, "pixels are uploaded as RGBA bytes");
+
+    const sf::Color palette[3] = { deadCellColor, aliveCellColor, bloodyCellColor };
+    unsigned int left = rect.x, right = rect.x + rect.width;
+    unsigned int top = rect.y, bottom = rect.y + rect.height;
 
-            if (cellSize > 1.f)
+    // Tiles of 64 columns by one word of rows: the column words are read once per
+    // tile and the pixels written in row order. Word rows own disjoint pixels.
+    uint64_t aliveWords[64], bloodyWords[64];
+    for (unsigned int word = wordBegin; word < wordEnd; word++)
+    {
+        unsigned int rowBegin = std::max(top, word * 64), rowEnd = std::min(bottom, word * 64 + 64);
+        for (unsigned int tileLeft = left; tileLeft < right; tileLeft += 64)
+        {
+            unsigned int tileRight = std::min(right, tileLeft + 64);
+            for (unsigned int x = tileLeft; x < tileRight; x++)
             {
-                sf::Vertex* quadOffset = &verticles[i * 4];
-
-                for (unsigned int j = 0; j < 4; j++)
-                {
-                    if(gameField[x][y] == 1)
-                        quadOffset[j].color = aliveCellColor;
-					else if (gameField[x][y] == 2)
-						quadOffset[j].color = bloodyCellColor;
-                    else if (gameField[x][y] == 0)
-                        quadOffset[j].color = deadCellColor;
-                }
-
-                quadOffset[0].position = sf::Vector2f(curPosX, curPosY);
-                quadOffset[1].position = sf::Vector2f(curPosX + cellSize, curPosY);
-                quadOffset[2].position = sf::Vector2f(curPosX + cellSize, curPosY + cellSize);
-                quadOffset[3].position = sf::Vector2f(curPosX, curPosY + cellSize);
+                aliveWords[x - tileLeft] = shownField.AliveColumn(x)[word];
+                bloodyWords[x - tileLeft] = shownField.BloodyColumn(x)[word];
             }
-            else
-            {
-                sf::Vertex* vertex = &verticles[i];
-
-                if(gameField[x][y] == 1)
-                    vertex->color = aliveCellColor;
-				else if (gameField[x][y] == 2)
-					vertex->color = bloodyCellColor;
-                else if (gameField[x][y] == 0)
-                    vertex->color = deadCellColor;
 
-                vertex->position = sf::Vector2f(curPosX, curPosY);
+            for (unsigned int y = rowBegin; y < rowEnd; y++)
+            {
+                unsigned int shift = y & 63;
+                sf::Color* row = pixels.data() + (size_t)y * textureSize.x;
+                for (unsigned int x = tileLeft; x < tileRight; x++)
+                    row[x] = palette[((aliveWords[x - tileLeft] >> shift) & 1) | (((bloodyWords[x - tileLeft] >> shift) & 1) << 1)];
             }
-            i++;
         }
     }
-}
\ No newline at end of file
+}
+
+void GameField::FinishPrepare(const CellRect& rect)
+{
+    preparedRect = rect;
+    preparing = false;
+}
+
+void GameField::UploadTexture()
+{
+    // empty while a conversion runs, it only starts once the last one is uploaded
+    if (preparedRect.IsEmpty())
+        return;
+
+    // whole rows go up in one call, the pixels are laid out like the texture
+    cellTexture.update((const sf::Uint8*)(pixels.data() + (size_t)preparedRect.y * textureSize.x), textureSize.x, preparedRect.height, 0, preparedRect.y);
+    preparedRect = CellRect();
+}
@@ -1,16 +1,16 @@
 #pragma once 
 
 #include "SFML.hpp"
-#include "Randomizer.hpp"
-#include <filesystem>
-#include <fstream>
-#include <utility>
+#include "EditBatch.hpp"
+#include "Simulation.hpp"
+#include <vector>
 
 
 class GameField : public sf::Drawable
 {
 public:
-    GameField(unsigned int fieldWidth, unsigned int fieldHeight, const sf::Vector2f& fieldPosition, unsigned long long randomChance, unsigned long long randomChanceBloody, float cellSize, float cellGap, const sf::Color& aliveCellColor, const sf::Color& bloodyCellColor, const sf::Color& deadCellColor, const sf::Color& hoveredCellColor);
+    // takes over a simulation that may already be filled, its cells are drawn on the first upload
+    GameField(Simulation&& fieldSimulation, const sf::Vector2f& fieldPosition, float cellSize, float cellGap, const sf::Color& aliveCellColor, const sf::Color& bloodyCellColor, const sf::Color& deadCellColor, const sf::Color& hoveredCellColor, const sf::Color& gapColor);
 
     void draw(sf::RenderTarget& target, sf::RenderStates states = sf::RenderStates::Default) const;
 
@@ -24,6 +24,7 @@ public:
     bool Save(const std::string& filePath) const;
     void Clear();
     void NextGeneration();
+    void ShowFrame(const PlaneGrid& frame, unsigned long long generation);
 
     void SetCellSize(float cellSize);
     float GetCellSize() const;
@@ -32,13 +33,40 @@ public:
     float GetCellGap() const;    
 
     void SetLocalMousePosition(const sf::Vector2u& localMousePosition);
-    void MouseClicked();
+
+    // nullptr goes back to single cells, the stamp has to outlive its use as the cursor
+    void SetCursorPattern(const PatternStamp* cursorPattern);
+    // an empty rect hides the selection outline
+    void SetSelection(const CellRect& selection);
+
+    // applies the batch and redraws only the cells it touched
+    void ApplyEdits(EditBatch& batch);
+
+    // Converts changed cells to pixels off the render thread. Only BeginPrepare() and
+    // FinishPrepare() touch the field, so only they need the caller's field lock.
+    // BeginPrepare() copies the cells changed since the last call aside and returns
+    // them, or an empty rect while the last pixels are still converting or not
+    // uploaded. PrepareRows() converts word rows [wordBegin, wordEnd) of that rect,
+    // several ranges can run at once. FinishPrepare() hands the pixels to the upload.
+    CellRect BeginPrepare();
+    void PrepareRows(const CellRect& rect, unsigned int wordBegin, unsigned int wordEnd);
+    void FinishPrepare(const CellRect& rect);
+    // render thread only, uploads the pixels of the last finished conversion
+    void UploadTexture();
 
     unsigned long long GetGeneration() const;
 
     void SetRandomChance(unsigned long long randomChance);
     unsigned long long GetRandomChance() const;
 
+    void SetRule(CellRule rule);
+    CellRule GetRule() const;
+
+    void SetRuleTable(uint16_t birth, uint16_t survive);
+
+    void SetTopology(FieldTopology topology);
+    FieldTopology GetTopology() const;
+
     void SetAliveCellColor(const sf::Color& aliveCellColor);
     const sf::Color& GetAliveCellColor() const;
 
@@ -56,23 +84,38 @@ public:
 
     bool IsStable() const;
 
+    Simulation& GetSimulation();
+    const Simulation& GetSimulation() const;
+
 private:
-	// important functions
-	unsigned int GetAliveNeighboursCount(const  std::vector<std::vector<unsigned int>>& field, unsigned int x, unsigned int y) const;
-	std::pair<unsigned int, unsigned int> SearchForPrey(const  std::vector<std::vector<unsigned int>>& field, unsigned int x, unsigned int y);
-    void UpdateVerticles();
+    void UpdatePitch();
+    void UpdateLayout();
+    void UpdateCursor();
+    void UpdateSelection();
+    void MarkDirty();
+    void MarkDirty(const CellRect& rect);
 
 private:
-    const char FILE_LIVING_CELL_CHAR = 'X';
-    std::vector<std::vector<unsigned int>> gameField;
-    sf::RectangleShape hoveredCellRect;
-    sf::VertexArray verticles;
+    Simulation simulation;
+    sf::RectangleShape hoveredCellRect, selectionRect;
+    // one texel per cell scaled up to the cell pitch, a repeated tile paints the gaps over it.
+    // pixels mirrors the texture, dirtyRect are cells changed since BeginPrepare() and
+    // preparedRect pixels that are not uploaded yet. shownField holds the cells being
+    // converted, so the conversion never reads the live field.
+    std::vector<sf::Color> pixels;
+    CellRect dirtyRect, preparedRect;
+    PlaneGrid shownField;
+    bool preparing;
+    sf::Texture cellTexture, gapTexture;
+    sf::Sprite cellSprite, gapSprite;
+    sf::Vector2u textureSize;
     sf::Vector2f position;
 
-    bool hoveredOnCell, stable;
-    Randomizer randomizer;
-    unsigned long long generation, randomChance, randomChanceBloody;
+    bool hoveredOnCell;
+    // cellSizeAndGap is the cell pitch rounded to whole pixels
     float cellSize, cellGap, cellSizeAndGap;
-    sf::Color aliveCellColor, bloodyCellColor, deadCellColor;
+    sf::Color aliveCellColor, bloodyCellColor, deadCellColor, gapColor;
     sf::Vector2u hoveredCellCoords;
+    const PatternStamp* cursorPattern;
+    CellRect selection;
 };
\ No newline at end of file
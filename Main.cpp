@@ -1,9 +1,145 @@
+#include "FieldFile.hpp"
 #include "Game.hpp"
 #include "Settings.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
 
-int main()
+// Usage: GameOfLife [--config FILE] [--size WxH] [--resolution WxH] [--cell-size N] [--cell-gap N]
+//                   [--random N] [--bloody N] [--autosave-generations N] [--autosave-seconds N]
+// Defaults come from Settings.hpp, autosave is off unless one of its options is
+// above 0. A config file holds the same options, any
+// number per line, # starts a comment. Options after --config override it. A
+// config may read another one with --config, but not itself.
+
+void PrintUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [--config FILE] [--size WxH] [--resolution WxH] [--cell-size N] [--cell-gap N]\n"
+        << "       [--random N] [--bloody N] [--autosave-generations N] [--autosave-seconds N]\n";
+}
+
+// Appends the options of a config file, the ones of nested configs in place of their
+// --config FILE. openPaths are the configs being read, one of them again is a loop.
+bool ReadConfigOptions(const std::string& filePath, std::vector<std::string>& options, std::vector<std::filesystem::path>& openPaths, std::string& error)
 {
-        std::unique_ptr<Game> GoL = std::make_unique<Game>(RES_X, RES_Y, MAX_FPS, RANDOM_CHANCE, BLOODY_CELL_RANDOM_CHANCE, CELL_SIZE, CELL_GAP, CELL_ALIVE_COLOR, CELL_BLOODY_COLOR, CELL_DEAD_COLOR, CELL_HOVERED_COLOR, BACKGROUND_COLOR);
+    std::error_code pathError;
+    std::filesystem::path path = std::filesystem::weakly_canonical(filePath, pathError);
+    if(pathError)
+        path = filePath;
+    if(std::find(openPaths.begin(), openPaths.end(), path) != openPaths.end())
+    {
+        error = "config " + filePath + " includes itself";
+        return false;
+    }
+
+    std::ifstream file(filePath);
+    if(!file.is_open())
+    {
+        error = "can't read config " + filePath;
+        return false;
+    }
+
+    openPaths.push_back(path);
+    std::string line;
+    bool nested = false;
+    while(std::getline(file, line))
+    {
+        std::istringstream words(line.substr(0, line.find('#')));
+        std::string word;
+        while(words >> word)
+        {
+            if(nested)
+            {
+                if(!ReadConfigOptions(word, options, openPaths, error))
+                    return false;
+                nested = false;
+            }
+            else if(word == "--config")
+                nested = true;
+            else
+                options.push_back(word);
+        }
+    }
+    openPaths.pop_back();
+
+    // a trailing --config without a file is left for the option parser to reject
+    if(nested)
+        options.push_back("--config");
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned int resX = RES_X, resY = RES_Y, fieldWidth = FIELD_WIDTH, fieldHeight = FIELD_HEIGHT;
+    float cellSize = CELL_SIZE, cellGap = CELL_GAP;
+    unsigned long long randomChance = RANDOM_CHANCE, randomChanceBloody = BLOODY_CELL_RANDOM_CHANCE;
+    unsigned long long autosaveGenerations = AUTOSAVE_GENERATIONS;
+    float autosaveSeconds = AUTOSAVE_SECONDS;
+
+    std::vector<std::string> options(argv + 1, argv + argc);
+    try
+    {
+        for(size_t i = 0; i < options.size(); i++)
+        {
+            std::string option = options[i];
+            if(i + 1 >= options.size())
+            {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            std::string value = options[++i];
+
+            if(option == "--config")
+            {
+                // the file's options are read in place of --config FILE
+                std::vector<std::string> configOptions;
+                std::vector<std::filesystem::path> openPaths;
+                std::string error;
+                if(!ReadConfigOptions(value, configOptions, openPaths, error))
+                {
+                    std::cerr << "Error: " << error << "\n";
+                    return 1;
+                }
+                options.insert(options.begin() + i + 1, configOptions.begin(), configOptions.end());
+            }
+            else if(option == "--size" || option == "--resolution")
+            {
+                if(!ParseSize(value, option == "--size" ? fieldWidth : resX, option == "--size" ? fieldHeight : resY))
+                {
+                    std::cerr << "Error: " << option << " expects WxH, got " << value << "\n";
+                    return 1;
+                }
+            }
+            else if(option == "--cell-size")
+                cellSize = std::max(1.f, std::stof(value));
+            else if(option == "--cell-gap")
+                cellGap = std::max(0.f, std::stof(value));
+            else if(option == "--random")
+                randomChance = std::max(1ull, std::stoull(value));
+            else if(option == "--bloody")
+                randomChanceBloody = std::stoull(value);
+            else if(option == "--autosave-generations")
+                autosaveGenerations = std::stoull(value);
+            else if(option == "--autosave-seconds")
+                autosaveSeconds = std::max(0.f, std::stof(value));
+            else
+            {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        }
+    }
+    catch(const std::exception&)
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+        std::unique_ptr<Game> GoL = std::make_unique<Game>(resX, resY, fieldWidth, fieldHeight, MAX_FPS, randomChance, randomChanceBloody, cellSize, cellGap, CELL_ALIVE_COLOR, CELL_BLOODY_COLOR, CELL_DEAD_COLOR, CELL_HOVERED_COLOR, BACKGROUND_COLOR, autosaveGenerations, autosaveSeconds);
         GoL->Run();
         return 0;
-}
\ No newline at end of file
+}
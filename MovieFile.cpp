@@ -0,0 +1,329 @@
+#include "MovieFile.hpp"
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    const uint8_t FRAME_KEYFRAME_FLAG = 0x80;
+
+    void PutVarint(std::string& output, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            output.push_back((char)((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        output.push_back((char)value);
+    }
+
+    bool GetVarint(const std::string& input, size_t& position, uint64_t& value)
+    {
+        value = 0;
+        for (unsigned int shift = 0; shift < 64 && position < input.size(); shift += 7)
+        {
+            uint8_t byte = (uint8_t)input[position++];
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    bool ReadVarint(std::istream& input, uint64_t& value)
+    {
+        value = 0;
+        for (unsigned int shift = 0; shift < 64; shift += 7)
+        {
+            int byte = input.get();
+            if (byte == std::char_traits<char>::eof())
+                return false;
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    // Builds the sparse and the run length payloads in one pass over the changed
+    // cells and gives up on each as soon as it grows past the bitmap size
+    class DeltaEncoder
+    {
+    public:
+        DeltaEncoder(size_t limit)
+            : sparseOpen(true), runsOpen(true), limit(limit), cursor(0), runLength(0), runValue(0)
+        {
+        }
+
+        bool IsOpen() const { return sparseOpen || runsOpen; }
+
+        void Add(uint64_t index, uint8_t value)
+        {
+            if (sparseOpen)
+            {
+                PutVarint(sparse, ((index - cursor) << 2) | value);
+                sparseOpen = sparse.size() <= limit;
+            }
+            if (runsOpen)
+            {
+                if (index > cursor)
+                    Extend(0, index - cursor);
+                Extend(value, 1);
+                runsOpen = runs.size() <= limit;
+            }
+            cursor = index + 1;
+        }
+
+        // trailing unchanged cells are implied, so the last zero run is never written
+        void Finish()
+        {
+            if (runValue != 0)
+                Flush();
+            runsOpen = runsOpen && runs.size() <= limit;
+        }
+
+        std::string sparse, runs;
+        bool sparseOpen, runsOpen;
+
+    private:
+        void Extend(uint8_t value, uint64_t length)
+        {
+            if (runLength > 0 && runValue == value)
+            {
+                runLength += length;
+                return;
+            }
+            Flush();
+            runValue = value;
+            runLength = length;
+        }
+
+        void Flush()
+        {
+            if (runLength > 0)
+                PutVarint(runs, ((runLength - 1) << 2) | runValue);
+            runLength = 0;
+        }
+
+        size_t limit;
+        uint64_t cursor, runLength;
+        uint8_t runValue;
+    };
+
+    bool ReadFrameHeader(std::istream& input, const MovieHeader& header, MovieFrameInfo& info, uint64_t& payloadSize)
+    {
+        int flags = input.get();
+        if (flags == std::char_traits<char>::eof())
+            return false;
+
+        uint8_t encoding = (uint8_t)flags & ~FRAME_KEYFRAME_FLAG;
+        if (encoding > (uint8_t)FrameEncoding::Sparse)
+            return false;
+
+        uint64_t generation;
+        if (!ReadVarint(input, generation) || !ReadVarint(input, payloadSize))
+            return false;
+        // no encoding is ever larger than the 2 bit per cell bitmap
+        if (payloadSize > ((uint64_t)header.width * header.height + 3) / 4)
+            return false;
+
+        info = MovieFrameInfo{ (flags & FRAME_KEYFRAME_FLAG) != 0, (FrameEncoding)encoding, generation };
+        return true;
+    }
+
+    bool ApplyCell(PlaneGrid& grid, uint64_t index, uint8_t value)
+    {
+        unsigned int height = grid.GetHeight();
+        if (index >= (uint64_t)grid.GetWidth() * height)
+            return false;
+
+        unsigned int x = (unsigned int)(index / height);
+        unsigned int y = (unsigned int)(index % height);
+        uint8_t cell = grid.Get(x, y) ^ value;
+        if (cell > CELL_BLOODY)
+            return false;
+        grid.Set(x, y, cell);
+        return true;
+    }
+}
+
+void EncodeMovieHeader(const MovieHeader& header, std::string& output)
+{
+    output.append(MOVIE_MAGIC, sizeof(MOVIE_MAGIC));
+    output.push_back((char)MOVIE_VERSION);
+    PutVarint(output, header.width);
+    PutVarint(output, header.height);
+    PutVarint(output, header.keyframeInterval);
+}
+
+bool ReadMovieHeader(std::istream& input, MovieHeader& header)
+{
+    char magic[sizeof(MOVIE_MAGIC)];
+    if (!input.read(magic, sizeof(magic)) || memcmp(magic, MOVIE_MAGIC, sizeof(magic)) != 0)
+        return false;
+    if (input.get() != MOVIE_VERSION)
+        return false;
+
+    uint64_t width, height, keyframeInterval;
+    if (!ReadVarint(input, width) || !ReadVarint(input, height) || !ReadVarint(input, keyframeInterval))
+        return false;
+    if (width > UINT32_MAX || height > UINT32_MAX || keyframeInterval > UINT32_MAX)
+        return false;
+
+    header = MovieHeader{ (unsigned int)width, (unsigned int)height, (unsigned int)keyframeInterval };
+    return true;
+}
+
+MovieFrameInfo EncodeMovieFrame(const PlaneGrid& previous, const PlaneGrid& current, unsigned long long generation, bool keyframe, std::string& output)
+{
+    unsigned int width = current.GetWidth();
+    unsigned int height = current.GetHeight();
+    size_t words = current.GetWordsPerColumn();
+    uint64_t cells = (uint64_t)width * height;
+    size_t bitmapSize = (size_t)((cells + 3) / 4);
+
+    std::vector<uint64_t> empty(keyframe ? words : 0, 0);
+    DeltaEncoder encoder(bitmapSize);
+
+    // calls change(index, value) for every changed cell in column order, stops early once change returns false
+    auto forEachChange = [&](auto change)
+    {
+        for (unsigned int x = 0; x < width; x++)
+        {
+            const uint64_t* oldAlive = keyframe ? empty.data() : previous.AliveColumn(x);
+            const uint64_t* oldBloody = keyframe ? empty.data() : previous.BloodyColumn(x);
+            const uint64_t* newAlive = current.AliveColumn(x);
+            const uint64_t* newBloody = current.BloodyColumn(x);
+            uint64_t columnIndex = (uint64_t)x * height;
+
+            // unchanged stretches are skipped 64 cells at a time
+            for (size_t i = 0; i < words; i++)
+            {
+                uint64_t aliveChanges = oldAlive[i] ^ newAlive[i];
+                uint64_t bloodyChanges = oldBloody[i] ^ newBloody[i];
+                for (uint64_t changes = aliveChanges | bloodyChanges; changes != 0; changes &= changes - 1)
+                {
+                    unsigned int bit = CountTrailingZeros(changes);
+                    uint8_t value = (uint8_t)(((aliveChanges >> bit) & 1) | (((bloodyChanges >> bit) & 1) << 1));
+                    if (!change(columnIndex + i * 64 + bit, value))
+                        return;
+                }
+            }
+        }
+    };
+
+    forEachChange([&](uint64_t index, uint8_t value)
+    {
+        encoder.Add(index, value);
+        return encoder.IsOpen();
+    });
+    encoder.Finish();
+
+    MovieFrameInfo info{ keyframe, FrameEncoding::XorBitmap, generation };
+    std::string bitmap;
+    const std::string* payload = &bitmap;
+
+    if (encoder.sparseOpen && (!encoder.runsOpen || encoder.sparse.size() <= encoder.runs.size()))
+    {
+        info.encoding = FrameEncoding::Sparse;
+        payload = &encoder.sparse;
+    }
+    else if (encoder.runsOpen)
+    {
+        info.encoding = FrameEncoding::RunLength;
+        payload = &encoder.runs;
+    }
+    else
+    {
+        bitmap.assign(bitmapSize, 0);
+        forEachChange([&](uint64_t index, uint8_t value)
+        {
+            bitmap[index >> 2] |= (char)(value << ((index & 3) * 2));
+            return true;
+        });
+    }
+
+    output.push_back((char)((keyframe ? FRAME_KEYFRAME_FLAG : 0) | (uint8_t)info.encoding));
+    PutVarint(output, generation);
+    PutVarint(output, payload->size());
+    output.append(*payload);
+    return info;
+}
+
+bool ReadMovieFrame(std::istream& input, const MovieHeader& header, MovieFrameInfo& info, std::string& payload)
+{
+    uint64_t payloadSize;
+    if (!ReadFrameHeader(input, header, info, payloadSize))
+        return false;
+
+    payload.resize((size_t)payloadSize);
+    return payloadSize == 0 || input.read(&payload[0], (std::streamsize)payloadSize);
+}
+
+bool SkipMovieFrame(std::istream& input, const MovieHeader& header, MovieFrameInfo& info)
+{
+    uint64_t payloadSize;
+    if (!ReadFrameHeader(input, header, info, payloadSize))
+        return false;
+
+    input.seekg((std::streamoff)payloadSize, std::ios::cur);
+    return (bool)input;
+}
+
+bool ApplyMovieFrame(const MovieFrameInfo& info, const std::string& payload, PlaneGrid& grid)
+{
+    if (info.keyframe)
+        grid.Clear();
+
+    uint64_t cells = (uint64_t)grid.GetWidth() * grid.GetHeight();
+    size_t position = 0;
+    uint64_t index = 0, code;
+
+    switch (info.encoding)
+    {
+    case FrameEncoding::XorBitmap:
+        if (payload.size() != (cells + 3) / 4)
+            return false;
+        for (size_t i = 0; i < payload.size(); i++)
+        {
+            uint8_t byte = (uint8_t)payload[i];
+            for (index = (uint64_t)i * 4; byte != 0; byte >>= 2, index++)
+            {
+                if ((byte & 3) && !ApplyCell(grid, index, byte & 3))
+                    return false;
+            }
+        }
+        return true;
+
+    case FrameEncoding::RunLength:
+        while (position < payload.size())
+        {
+            if (!GetVarint(payload, position, code))
+                return false;
+
+            uint64_t length = (code >> 2) + 1;
+            uint8_t value = code & 3;
+            if (length > cells - index)
+                return false;
+            for (uint64_t end = index + length; value != 0 && index < end; index++)
+            {
+                if (!ApplyCell(grid, index, value))
+                    return false;
+            }
+            index += value == 0 ? length : 0;
+        }
+        return true;
+
+    case FrameEncoding::Sparse:
+        while (position < payload.size())
+        {
+            if (!GetVarint(payload, position, code))
+                return false;
+
+            index += code >> 2;
+            if (!ApplyCell(grid, index++, code & 3))
+                return false;
+        }
+        return true;
+    }
+    return false;
+}
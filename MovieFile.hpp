@@ -0,0 +1,57 @@
+#pragma once
+
+#include "CellGrid.hpp"
+#include <istream>
+#include <string>
+
+// Movie files record a run generation by generation. After the header every frame
+// stores the cells that changed since the previous frame, every keyframeInterval
+// frames a keyframe stores the whole field so players can seek without replaying
+// from the start. Numbers are LEB128 varints.
+//
+//   header: "GOLM" version width height keyframeInterval
+//   frame:  flags generation payloadSize payload
+//
+// The payload describes the XOR of the old and the new cell state (a value 0..3)
+// for every cell in column order, using whichever of these is smallest:
+//   XorBitmap  2 bits per cell, 4 cells per byte
+//   RunLength  runs of equal values, varint (length - 1) << 2 | value
+//   Sparse     changed cells only, varint (cells skipped) << 2 | value
+
+const char MOVIE_MAGIC[4] = { 'G', 'O', 'L', 'M' };
+const uint8_t MOVIE_VERSION = 1;
+const unsigned int MOVIE_KEYFRAME_INTERVAL = 256;
+
+enum class FrameEncoding : uint8_t
+{
+    XorBitmap = 0,
+    RunLength = 1,
+    Sparse = 2
+};
+
+struct MovieHeader
+{
+    unsigned int width, height, keyframeInterval;
+};
+
+struct MovieFrameInfo
+{
+    bool keyframe;
+    FrameEncoding encoding;
+    unsigned long long generation;
+};
+
+void EncodeMovieHeader(const MovieHeader& header, std::string& output);
+bool ReadMovieHeader(std::istream& input, MovieHeader& header);
+
+// Appends one frame record to output, keyframes are stored against an empty field
+MovieFrameInfo EncodeMovieFrame(const PlaneGrid& previous, const PlaneGrid& current, unsigned long long generation, bool keyframe, std::string& output);
+
+// Reads the next frame record, false at the end of the file, on a truncated frame
+// or on a payload larger than any encoding of a header.width x header.height field
+bool ReadMovieFrame(std::istream& input, const MovieHeader& header, MovieFrameInfo& info, std::string& payload);
+// Same as ReadMovieFrame but seeks over the payload
+bool SkipMovieFrame(std::istream& input, const MovieHeader& header, MovieFrameInfo& info);
+
+// Applies a frame to the previous one, false if the payload is damaged
+bool ApplyMovieFrame(const MovieFrameInfo& info, const std::string& payload, PlaneGrid& grid);
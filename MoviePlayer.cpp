@@ -0,0 +1,134 @@
+#include "MoviePlayer.hpp"
+
+
+MoviePlayer::MoviePlayer()
+    : header{ 0, 0, MOVIE_KEYFRAME_INTERVAL }, generation(0), hasFrame(false)
+{
+}
+
+bool MoviePlayer::Open(const std::string& filePath)
+{
+    Close();
+
+    if (filePath == "")
+        return false;
+
+    file.open(filePath, std::ios::binary);
+    if (!file.is_open() || !ReadMovieHeader(file, header))
+    {
+        Close();
+        return false;
+    }
+
+    // only the frame headers are read here, the payloads are skipped
+    MovieFrameInfo info;
+    std::streamoff offset = file.tellg();
+    while (SkipMovieFrame(file, header, info))
+    {
+        if (info.keyframe)
+            keyframes.push_back(std::make_pair(info.generation, offset));
+        offset = file.tellg();
+    }
+
+    // the scan only stops before the end on a damaged frame header
+    if (keyframes.empty() || !file.eof())
+    {
+        Close();
+        return false;
+    }
+
+    frame = PlaneGrid(header.width, header.height);
+    return Rewind();
+}
+
+void MoviePlayer::Close()
+{
+    if (file.is_open())
+        file.close();
+    file.clear();
+    keyframes.clear();
+    frame = PlaneGrid();
+    generation = 0;
+    hasFrame = false;
+}
+
+bool MoviePlayer::IsOpen() const
+{
+    return file.is_open();
+}
+
+unsigned int MoviePlayer::GetWidth() const
+{
+    return header.width;
+}
+
+unsigned int MoviePlayer::GetHeight() const
+{
+    return header.height;
+}
+
+bool MoviePlayer::NextFrame()
+{
+    MovieFrameInfo info;
+    if (!file.is_open() || !ReadMovieFrame(file, header, info, payload))
+        return false;
+
+    // a delta needs the frame it was taken against
+    if (!info.keyframe && !hasFrame)
+        return false;
+
+    hasFrame = ApplyMovieFrame(info, payload, frame);
+    generation = info.generation;
+    return hasFrame;
+}
+
+bool MoviePlayer::Rewind()
+{
+    if (keyframes.empty())
+        return false;
+
+    file.clear();
+    file.seekg(keyframes.front().second);
+    hasFrame = false;
+    return NextFrame();
+}
+
+bool MoviePlayer::Seek(unsigned long long generation)
+{
+    if (keyframes.empty())
+        return false;
+
+    size_t keyframe = 0;
+    while (keyframe + 1 < keyframes.size() && keyframes[keyframe + 1].first <= generation)
+        keyframe++;
+
+    file.clear();
+    file.seekg(keyframes[keyframe].second);
+    hasFrame = false;
+    if (!NextFrame())
+        return false;
+
+    while (this->generation < generation)
+    {
+        // peek at the next frame header and stop before overshooting
+        MovieFrameInfo info;
+        std::streamoff offset = file.tellg();
+        bool more = SkipMovieFrame(file, header, info);
+        file.clear();
+        file.seekg(offset);
+
+        if (!more || info.generation > generation || !NextFrame())
+            break;
+    }
+    return hasFrame;
+}
+
+const PlaneGrid& MoviePlayer::GetFrame() const
+{
+    return frame;
+}
+
+unsigned long long MoviePlayer::GetGeneration() const
+{
+    return generation;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "MovieFile.hpp"
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+// Decodes a movie frame by frame, the frames come straight from the file
+// so playback never runs the simulation.
+class MoviePlayer
+{
+public:
+    MoviePlayer();
+
+    // reads the header and indexes the keyframes
+    bool Open(const std::string& filePath);
+    void Close();
+    bool IsOpen() const;
+
+    unsigned int GetWidth() const;
+    unsigned int GetHeight() const;
+
+    // false at the end of the movie or on a damaged frame
+    bool NextFrame();
+    bool Rewind();
+    // decodes from the last keyframe at or before generation up to the last frame not after it
+    bool Seek(unsigned long long generation);
+
+    const PlaneGrid& GetFrame() const;
+    unsigned long long GetGeneration() const;
+
+private:
+    std::ifstream file;
+    MovieHeader header;
+    PlaneGrid frame;
+    std::string payload;
+    unsigned long long generation;
+    bool hasFrame;
+
+    // generation and file offset of every keyframe
+    std::vector<std::pair<unsigned long long, std::streamoff>> keyframes;
+};
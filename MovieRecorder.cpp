@@ -0,0 +1,158 @@
+#include "MovieRecorder.hpp"
+
+
+MovieRecorder::MovieRecorder(TaskScheduler& scheduler)
+    : width(0), height(0), keyframeInterval(MOVIE_KEYFRAME_INTERVAL), recording(false), writing(false), failed(false), frameCount(0), bytesWritten(0), scheduler(scheduler), roomGate(scheduler, true)
+{
+}
+
+MovieRecorder::~MovieRecorder()
+{
+    Stop();
+}
+
+bool MovieRecorder::Start(const std::string& filePath, unsigned int width, unsigned int height, unsigned int keyframeInterval)
+{
+    Stop();
+
+    if (filePath == "")
+        return false;
+
+    file.open(filePath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+        return false;
+
+    this->width = width;
+    this->height = height;
+    this->keyframeInterval = keyframeInterval > 0 ? keyframeInterval : MOVIE_KEYFRAME_INTERVAL;
+
+    std::string header;
+    EncodeMovieHeader(MovieHeader{ width, height, this->keyframeInterval }, header);
+    file.write(header.data(), (std::streamsize)header.size());
+
+    recording = true;
+    failed = file.fail();
+    frameCount = 0;
+    bytesWritten = header.size();
+    previous.reset();
+    batch.clear();
+    return true;
+}
+
+void MovieRecorder::AddFrame(std::shared_ptr<const FieldSnapshot> snapshot)
+{
+    if (!recording || snapshot->grid.GetWidth() != width || snapshot->grid.GetHeight() != height)
+        return;
+
+    bool startWriting;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        frames.push_back(std::move(snapshot));
+        if (frames.size() >= MAX_PENDING_FRAMES)
+            roomGate.Close();
+
+        // one task drains the queue, it ends when the queue is empty
+        startWriting = !writing;
+        writing = true;
+    }
+    if (startWriting)
+        scheduler.Spawn(WriteFrames());
+}
+
+PauseGate::Awaiter MovieRecorder::WaitForRoom()
+{
+    return roomGate.Wait();
+}
+
+void MovieRecorder::BlockForRoom()
+{
+    std::unique_lock<std::mutex> lock(queueMutex);
+    frameTaken.wait(lock, [this]() { return frames.size() < MAX_PENDING_FRAMES; });
+}
+
+void MovieRecorder::EndRecording()
+{
+    recording = false;
+}
+
+bool MovieRecorder::Stop()
+{
+    recording = false;
+    if (!file.is_open())
+        return true;
+
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        frameTaken.wait(lock, [this]() { return !writing; });
+    }
+
+    // the last partial batch is written here, the writing task has ended
+    if (!batch.empty())
+    {
+        file.write(batch.data(), (std::streamsize)batch.size());
+        bytesWritten += batch.size();
+        batch.clear();
+    }
+    failed = failed || file.fail();
+    previous.reset();
+
+    file.close();
+    return !failed && !file.fail();
+}
+
+bool MovieRecorder::IsRecording() const
+{
+    return recording;
+}
+
+unsigned long long MovieRecorder::GetFrameCount() const
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return frameCount;
+}
+
+unsigned long long MovieRecorder::GetBytesWritten() const
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return bytesWritten;
+}
+
+Task MovieRecorder::WriteFrames()
+{
+    std::unique_lock<std::mutex> lock(queueMutex);
+
+    while (!frames.empty())
+    {
+        std::shared_ptr<const FieldSnapshot> snapshot = std::move(frames.front());
+        frames.pop_front();
+        if (frames.size() < MAX_PENDING_FRAMES && !roomGate.IsOpen())
+            roomGate.Open();
+        bool keyframe = previous == nullptr || frameCount % keyframeInterval == 0;
+        lock.unlock();
+        frameTaken.notify_all();
+
+        EncodeMovieFrame(keyframe ? snapshot->grid : previous->grid, snapshot->grid, snapshot->generation, keyframe, batch);
+        previous = std::move(snapshot);
+
+        size_t written = 0;
+        if (batch.size() >= WRITE_BATCH_BYTES)
+        {
+            file.write(batch.data(), (std::streamsize)batch.size());
+            written = batch.size();
+            batch.clear();
+        }
+
+        lock.lock();
+        frameCount++;
+        bytesWritten += written;
+        failed = failed || file.fail();
+
+        // other tasks get the worker between two frames
+        lock.unlock();
+        co_await scheduler.Schedule();
+        lock.lock();
+    }
+
+    writing = false;
+    frameTaken.notify_all();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "MovieFile.hpp"
+#include "Simulation.hpp"
+#include "TaskScheduler.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+
+
+// Appends generations to a movie file. Frames are delta encoded and written in
+// batches by a scheduler task that runs while frames are queued, the caller only
+// pays for the snapshot copy.
+class MovieRecorder
+{
+public:
+    explicit MovieRecorder(TaskScheduler& scheduler);
+    MovieRecorder(MovieRecorder const &) = delete;
+    void operator=(MovieRecorder) = delete;
+    ~MovieRecorder();
+
+    bool Start(const std::string& filePath, unsigned int width, unsigned int height, unsigned int keyframeInterval = MOVIE_KEYFRAME_INTERVAL);
+
+    // queues the frame without waiting, a movie never drops frames. Callers keep
+    // the queue short with WaitForRoom() or BlockForRoom() once their locks are released.
+    void AddFrame(std::shared_ptr<const FieldSnapshot> snapshot);
+
+    // co_await WaitForRoom() parks a task while MAX_PENDING_FRAMES are waiting
+    PauseGate::Awaiter WaitForRoom();
+    // the same for threads that are no task, the caller must not be the only worker of the scheduler
+    void BlockForRoom();
+
+    // AddFrame() ignores frames from here on, returns at once so it can be called
+    // under the lock the frame producers hold. Stop() still writes the queued ones.
+    void EndRecording();
+    // Writes the remaining frames and closes the file, false if any write failed.
+    // Waits for the writing task, so the caller must not hold a lock a worker waits for.
+    bool Stop();
+
+    bool IsRecording() const;
+    unsigned long long GetFrameCount() const;
+    unsigned long long GetBytesWritten() const;
+
+private:
+    Task WriteFrames();
+
+    const size_t MAX_PENDING_FRAMES = 64;
+    const size_t WRITE_BATCH_BYTES = 1 << 20;
+
+    std::ofstream file;
+    unsigned int width, height, keyframeInterval;
+    std::atomic<bool> recording;
+    bool writing, failed;
+    unsigned long long frameCount, bytesWritten;
+
+    std::deque<std::shared_ptr<const FieldSnapshot>> frames;
+    mutable std::mutex queueMutex;
+    std::condition_variable frameTaken;
+
+    // only touched by the writing task, or by Stop() once it has ended
+    std::shared_ptr<const FieldSnapshot> previous;
+    std::string batch;
+
+    TaskScheduler& scheduler;
+    // closed while the queue is full
+    PauseGate roomGate;
+};
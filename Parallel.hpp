@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+const unsigned int PARALLEL_MIN_CELLS = 1u << 16;
+
+// Smallest column chunk worth a thread, small fields stay on the calling thread
+inline unsigned int ColumnsPerChunk(unsigned int height)
+{
+    return std::max(1u, PARALLEL_MIN_CELLS / std::max(1u, height));
+}
+
+// Depth of SerialSections on this thread, see below
+inline thread_local unsigned int serialSectionDepth = 0;
+
+// ParallelFor runs inline on the calling thread while one of these is alive. Worker
+// pools open one on every worker, the pool already keeps each core busy.
+class SerialSection
+{
+public:
+    SerialSection() { serialSectionDepth++; }
+    ~SerialSection() { serialSectionDepth--; }
+    SerialSection(SerialSection const &) = delete;
+    void operator=(SerialSection) = delete;
+};
+
+// Splits [begin, end) into one contiguous chunk per hardware thread and runs
+// function(chunkBegin, chunkEnd) on each. The calling thread takes the last chunk.
+// Chunks smaller than minChunk are merged so small ranges stay on one thread.
+template <typename Function>
+void ParallelFor(unsigned int begin, unsigned int end, Function function, unsigned int minChunk = 16)
+{
+    if (end <= begin)
+        return;
+
+    if (serialSectionDepth > 0)
+    {
+        function(begin, end);
+        return;
+    }
+
+    unsigned int count = end - begin;
+    unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::max(1u, std::min(threadCount, count / std::max(1u, minChunk)));
+
+    std::vector<std::thread> workers;
+    unsigned int chunkBegin = begin;
+    for (unsigned int i = 0; i < threadCount; i++)
+    {
+        unsigned int chunkEnd = begin + (unsigned int)((unsigned long long)count * (i + 1) / threadCount);
+        if (i + 1 < threadCount)
+            workers.emplace_back(function, chunkBegin, chunkEnd);
+        else
+            function(chunkBegin, chunkEnd);
+        chunkBegin = chunkEnd;
+    }
+
+    for (auto& worker : workers)
+        worker.join();
+}
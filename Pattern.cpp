@@ -0,0 +1,357 @@
+#include "Pattern.hpp"
+#include "FieldFile.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+#include <utility>
+
+namespace
+{
+    const unsigned int PATTERN_MAX_SIZE = 1u << 16;
+
+    std::vector<std::string> SplitLines(const std::string& text)
+    {
+        std::vector<std::string> lines;
+        for (size_t start = 0; start < text.size();)
+        {
+            size_t end = text.find('\n', start);
+            if (end == std::string::npos)
+                end = text.size();
+
+            size_t length = end - start;
+            if (length > 0 && text[end - 1] == '\r')
+                length--;
+
+            lines.push_back(text.substr(start, length));
+            start = end + 1;
+        }
+        return lines;
+    }
+
+    bool ParsePlainText(const std::string& text, bool cells, PatternStamp& stamp)
+    {
+        std::vector<std::string> rows;
+        for (const std::string& line : SplitLines(text))
+        {
+            if (!(cells && !line.empty() && line[0] == '!'))
+                rows.push_back(line);
+        }
+        while (!rows.empty() && rows.back().empty())
+            rows.pop_back();
+
+        size_t width = 0;
+        for (const std::string& row : rows)
+            width = std::max(width, row.size());
+        if (rows.empty() || width == 0 || width > PATTERN_MAX_SIZE || rows.size() > PATTERN_MAX_SIZE)
+            return false;
+
+        stamp.Resize((unsigned int)width, (unsigned int)rows.size());
+        for (unsigned int y = 0; y < rows.size(); y++)
+        {
+            for (unsigned int x = 0; x < rows[y].size(); x++)
+            {
+                char c = rows[y][x];
+                if (cells ? c == 'O' : toupper(c) == FILE_LIVING_CELL_CHAR)
+                    stamp.Set(x, y);
+            }
+        }
+        return true;
+    }
+
+    // "x = 3, y = 3, rule = B3/S23" followed by runs like "bo$2bo$3o!"
+    bool ParseRunLength(const std::string& text, PatternStamp& stamp)
+    {
+        unsigned long long width = 0, height = 0;
+        unsigned long long x = 0, y = 0, count = 0;
+        std::vector<std::pair<unsigned int, unsigned int>> alive;
+        bool header = false, finished = false;
+
+        for (const std::string& line : SplitLines(text))
+        {
+            size_t first = line.find_first_not_of(" \t");
+            if (first == std::string::npos || line[first] == '#')
+                continue;
+
+            if (!header)
+            {
+                header = true;
+                if (line[first] == 'x')
+                {
+                    std::istringstream items(line);
+                    std::string item;
+                    while (std::getline(items, item, ','))
+                    {
+                        size_t equals = item.find('=');
+                        std::string key = item.substr(0, equals);
+                        key.erase(std::remove_if(key.begin(), key.end(), [](char c) { return isspace((unsigned char)c) != 0; }), key.end());
+                        if (equals != std::string::npos && (key == "x" || key == "y"))
+                            (key == "x" ? width : height) = strtoull(item.c_str() + equals + 1, nullptr, 10);
+                    }
+                    continue;
+                }
+            }
+
+            for (size_t i = first; i < line.size() && !finished; i++)
+            {
+                char c = line[i];
+                if (isdigit((unsigned char)c))
+                {
+                    count = count * 10 + (c - '0');
+                    if (count > PATTERN_MAX_SIZE)
+                        return false;
+                    continue;
+                }
+
+                unsigned long long run = count > 0 ? count : 1;
+                count = 0;
+                if (c == '!')
+                    finished = true;
+                else if (c == '$')
+                {
+                    y += run;
+                    x = 0;
+                }
+                else if (c == 'b' || c == '.')
+                    x += run;
+                else if (isalpha((unsigned char)c))
+                {
+                    for (unsigned long long cell = 0; cell < run; cell++, x++)
+                        alive.push_back(std::make_pair((unsigned int)x, (unsigned int)y));
+                    height = std::max(height, y + 1);
+                }
+                else if (!isspace((unsigned char)c))
+                    return false;
+
+                width = std::max(width, x);
+                if (x > PATTERN_MAX_SIZE || y > PATTERN_MAX_SIZE)
+                    return false;
+            }
+        }
+
+        if (width == 0 || height == 0 || width > PATTERN_MAX_SIZE || height > PATTERN_MAX_SIZE)
+            return false;
+
+        stamp.Resize((unsigned int)width, (unsigned int)height);
+        for (const auto& cell : alive)
+            stamp.Set(cell.first, cell.second);
+        return true;
+    }
+
+    // bits i of the result is row start + i of the column, rows outside the column are dead
+    uint64_t ExtractRows(const uint64_t* column, size_t words, long long start)
+    {
+        if (start < 0)
+            return start > -64 ? column[0] << -start : 0;
+
+        size_t word = (size_t)(start >> 6);
+        unsigned int shift = start & 63;
+        uint64_t low = word < words ? column[word] >> shift : 0;
+        uint64_t high = shift != 0 && word + 1 < words ? column[word + 1] << (64 - shift) : 0;
+        return low | high;
+    }
+
+    // bits from to to - 1 set
+    uint64_t RangeMask(unsigned int from, unsigned int to)
+    {
+        uint64_t below = to >= 64 ? ~0ull : (1ull << to) - 1;
+        return below & (~0ull << from);
+    }
+}
+
+void PatternStamp::Resize(unsigned int width, unsigned int height)
+{
+    this->width = width;
+    this->height = height;
+    wordsPerColumn = ((size_t)height + 63) / 64;
+    columns.assign((size_t)width * wordsPerColumn, 0);
+}
+
+bool ParsePattern(const std::string& text, const std::string& extension, PatternStamp& stamp)
+{
+    std::string format = extension;
+    std::transform(format.begin(), format.end(), format.begin(), [](char c) { return (char)tolower(c); });
+
+    if (format == ".rle")
+        return ParseRunLength(text, stamp);
+    return ParsePlainText(text, format == ".cells", stamp);
+}
+
+PatternStamp OrientPattern(const PatternStamp& stamp, unsigned int orientation)
+{
+    unsigned int turns = orientation & 3;
+    bool mirror = (orientation & PATTERN_MIRROR) != 0;
+
+    PatternStamp result;
+    result.Resize(turns % 2 ? stamp.height : stamp.width, turns % 2 ? stamp.width : stamp.height);
+
+    for (unsigned int x = 0; x < stamp.width; x++)
+    {
+        for (unsigned int y = 0; y < stamp.height; y++)
+        {
+            if (!stamp.Get(x, y))
+                continue;
+
+            unsigned int orientedX = mirror ? stamp.width - 1 - x : x, orientedY = y;
+            unsigned int width = stamp.width, height = stamp.height;
+            for (unsigned int turn = 0; turn < turns; turn++)
+            {
+                // clockwise: the left column becomes the top row
+                unsigned int turnedX = height - 1 - orientedY;
+                orientedY = orientedX;
+                orientedX = turnedX;
+                std::swap(width, height);
+            }
+            result.Set(orientedX, orientedY);
+        }
+    }
+    return result;
+}
+
+CellRect StampPattern(const PatternStamp& stamp, PlaneGrid& grid, int x, int y, bool replace)
+{
+    long long left = std::max(x, 0), top = std::max(y, 0);
+    long long right = std::min((long long)x + stamp.width, (long long)grid.GetWidth());
+    long long bottom = std::min((long long)y + stamp.height, (long long)grid.GetHeight());
+    if (left >= right || top >= bottom)
+        return CellRect();
+
+    size_t firstWord = (size_t)(top >> 6), lastWord = (size_t)((bottom - 1) >> 6);
+    for (long long column = left; column < right; column++)
+    {
+        const uint64_t* source = stamp.Column((unsigned int)(column - x));
+        uint64_t* alive = grid.AliveColumn((int)column);
+        uint64_t* bloody = grid.BloodyColumn((int)column);
+
+        for (size_t i = firstWord; i <= lastWord; i++)
+        {
+            long long wordTop = (long long)i * 64;
+            uint64_t mask = RangeMask((unsigned int)(std::max(top, wordTop) - wordTop), (unsigned int)(std::min(bottom, wordTop + 64) - wordTop));
+            uint64_t bits = ExtractRows(source, stamp.wordsPerColumn, wordTop - y) & mask;
+
+            if (replace)
+            {
+                alive[i] = (alive[i] & ~mask) | bits;
+                bloody[i] &= ~mask;
+            }
+            else
+            {
+                alive[i] |= bits;
+                bloody[i] &= ~bits;
+            }
+        }
+    }
+    return CellRect{ (unsigned int)left, (unsigned int)top, (unsigned int)(right - left), (unsigned int)(bottom - top) };
+}
+
+PatternStamp CopyPattern(const PlaneGrid& grid, const CellRect& rect)
+{
+    unsigned int right = std::min(rect.x + rect.width, grid.GetWidth()), bottom = std::min(rect.y + rect.height, grid.GetHeight());
+    PatternStamp stamp;
+    if (rect.IsEmpty() || rect.x >= right || rect.y >= bottom)
+        return stamp;
+
+    stamp.Resize(right - rect.x, bottom - rect.y);
+    uint64_t lastMask = stamp.height % 64 != 0 ? (1ull << (stamp.height % 64)) - 1 : ~0ull;
+    for (unsigned int x = 0; x < stamp.width; x++)
+    {
+        const uint64_t* alive = grid.AliveColumn((int)(rect.x + x));
+        uint64_t* column = stamp.columns.data() + x * stamp.wordsPerColumn;
+        for (size_t i = 0; i < stamp.wordsPerColumn; i++)
+            column[i] = ExtractRows(alive, grid.GetWordsPerColumn(), (long long)rect.y + (long long)i * 64);
+        column[stamp.wordsPerColumn - 1] &= lastMask;
+    }
+    return stamp;
+}
+
+CellRect FillCells(PlaneGrid& grid, const CellRect& rect, uint8_t state)
+{
+    unsigned int right = std::min(rect.x + rect.width, grid.GetWidth()), bottom = std::min(rect.y + rect.height, grid.GetHeight());
+    if (rect.IsEmpty() || rect.x >= right || rect.y >= bottom)
+        return CellRect();
+
+    size_t firstWord = rect.y >> 6, lastWord = (bottom - 1) >> 6;
+    for (unsigned int x = rect.x; x < right; x++)
+    {
+        uint64_t* alive = grid.AliveColumn((int)x);
+        uint64_t* bloody = grid.BloodyColumn((int)x);
+        for (size_t i = firstWord; i <= lastWord; i++)
+        {
+            unsigned int wordTop = (unsigned int)i * 64;
+            uint64_t mask = RangeMask(std::max(rect.y, wordTop) - wordTop, std::min(bottom, wordTop + 64) - wordTop);
+            alive[i] = state == CELL_ALIVE ? alive[i] | mask : alive[i] & ~mask;
+            bloody[i] = state == CELL_BLOODY ? bloody[i] | mask : bloody[i] & ~mask;
+        }
+    }
+    return CellRect{ rect.x, rect.y, right - rect.x, bottom - rect.y };
+}
+
+size_t PatternLibrary::LoadDirectory(const std::string& directory)
+{
+    std::error_code error;
+    std::vector<std::filesystem::path> files;
+    for (std::filesystem::directory_iterator entry(directory, error), end; !error && entry != end; entry.increment(error))
+    {
+        if (entry->is_regular_file(error))
+            files.push_back(entry->path());
+    }
+    std::sort(files.begin(), files.end());
+
+    size_t loaded = 0;
+    for (const std::filesystem::path& file : files)
+    {
+        std::string extension = file.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)tolower(c); });
+        if (extension != ".txt" && extension != ".cells" && extension != ".rle")
+            continue;
+
+        std::string text;
+        if (ReadFileText(file.string(), text) && Add(file.stem().string(), text, extension))
+            loaded++;
+    }
+    return loaded;
+}
+
+bool PatternLibrary::Add(const std::string& name, const std::string& text, const std::string& extension)
+{
+    Entry entry;
+    entry.name = name;
+    if (!ParsePattern(text, extension, entry.stamps[0]))
+        return false;
+
+    for (unsigned int orientation = 1; orientation < PATTERN_ORIENTATIONS; orientation++)
+        entry.stamps[orientation] = OrientPattern(entry.stamps[0], orientation);
+
+    auto existing = std::find_if(patterns.begin(), patterns.end(), [&](const Entry& pattern) { return pattern.name == name; });
+    if (existing != patterns.end())
+        *existing = std::move(entry);
+    else
+        patterns.push_back(std::move(entry));
+    return true;
+}
+
+size_t PatternLibrary::GetCount() const
+{
+    return patterns.size();
+}
+
+const std::string& PatternLibrary::GetName(size_t index) const
+{
+    return patterns[index].name;
+}
+
+const PatternStamp& PatternLibrary::GetStamp(size_t index, unsigned int orientation) const
+{
+    return patterns[index].stamps[orientation % PATTERN_ORIENTATIONS];
+}
+
+const PatternStamp* PatternLibrary::Find(const std::string& name, unsigned int orientation) const
+{
+    for (const Entry& pattern : patterns)
+    {
+        if (pattern.name == name)
+            return &pattern.stamps[orientation % PATTERN_ORIENTATIONS];
+    }
+    return nullptr;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "CellGrid.hpp"
+#include <string>
+#include <vector>
+
+// Pattern files are parsed once into stamps, bitmaps of alive cells stored in
+// columns of 64-bit words like the PlaneGrid planes, so a stamp is blitted a
+// word at a time. Supported files:
+//   .txt     field files, FILE_LIVING_CELL_CHAR marks alive cells
+//   .cells   plaintext, 'O' marks alive cells and lines starting with '!' are comments
+//   .rle     run length encoded, as used by most pattern collections
+
+// 8 orientations: bits 0-1 are quarter turns clockwise, bit 2 mirrors left to right before turning
+const unsigned int PATTERN_ORIENTATIONS = 8;
+const unsigned int PATTERN_MIRROR = 4;
+
+struct PatternStamp
+{
+    unsigned int width = 0, height = 0;
+    size_t wordsPerColumn = 0;
+    std::vector<uint64_t> columns;
+
+    void Resize(unsigned int width, unsigned int height);
+    bool Get(unsigned int x, unsigned int y) const { return (Column(x)[y >> 6] >> (y & 63)) & 1; }
+    void Set(unsigned int x, unsigned int y) { columns[x * wordsPerColumn + (y >> 6)] |= 1ull << (y & 63); }
+    const uint64_t* Column(unsigned int x) const { return columns.data() + x * wordsPerColumn; }
+};
+
+// extension selects the format, false if the text is not a pattern
+bool ParsePattern(const std::string& text, const std::string& extension, PatternStamp& stamp);
+PatternStamp OrientPattern(const PatternStamp& stamp, unsigned int orientation);
+
+// Blits the stamp with its top left corner at x, y and clips it to the grid. replace
+// also kills the dead cells of the stamp's box, otherwise alive cells are added.
+// Returns the cells that were touched.
+CellRect StampPattern(const PatternStamp& stamp, PlaneGrid& grid, int x, int y, bool replace);
+// The alive cells inside rect, clipped to the grid. Bloody cells are not copied.
+PatternStamp CopyPattern(const PlaneGrid& grid, const CellRect& rect);
+// Sets every cell inside rect to state a word at a time, returns the clipped rect
+CellRect FillCells(PlaneGrid& grid, const CellRect& rect, uint8_t state);
+
+class PatternLibrary
+{
+public:
+    // loads every pattern file in the directory, the file name without extension is the pattern name
+    size_t LoadDirectory(const std::string& directory);
+    bool Add(const std::string& name, const std::string& text, const std::string& extension);
+
+    size_t GetCount() const;
+    const std::string& GetName(size_t index) const;
+    const PatternStamp& GetStamp(size_t index, unsigned int orientation) const;
+    // nullptr if there is no pattern with that name
+    const PatternStamp* Find(const std::string& name, unsigned int orientation) const;
+
+private:
+    struct Entry
+    {
+        std::string name;
+        PatternStamp stamps[PATTERN_ORIENTATIONS];
+    };
+
+    std::vector<Entry> patterns;
+};
@@ -0,0 +1,89 @@
+#include "PatternScript.hpp"
+#include "FieldFile.hpp"
+#include <sstream>
+
+
+bool PatternScript::Load(const std::string& filePath, const PatternLibrary& library, std::string& error)
+{
+    std::string text;
+    if (!ReadFileText(filePath, text))
+    {
+        error = "can't open " + filePath;
+        return false;
+    }
+    return Parse(text, library, error);
+}
+
+bool PatternScript::Parse(const std::string& text, const PatternLibrary& library, std::string& error)
+{
+    this->library = &library;
+    placements.clear();
+
+    // names are looked up once per distinct pattern, scripts tend to repeat a few
+    std::string lastName;
+    size_t lastPattern = 0;
+
+    std::istringstream lines(text);
+    std::string line;
+    unsigned int lineNumber = 0;
+    while (std::getline(lines, line))
+    {
+        lineNumber++;
+        std::istringstream words(line.substr(0, line.find('#')));
+        std::string name;
+        if (!(words >> name))
+            continue;
+
+        PatternPlacement placement{ 0, 0, 0, 0, false };
+        if (!(words >> placement.x >> placement.y))
+        {
+            error = "line " + std::to_string(lineNumber) + ": expected name x y";
+            return false;
+        }
+
+        if (name != lastName)
+        {
+            for (lastPattern = 0; lastPattern < library.GetCount() && library.GetName(lastPattern) != name; lastPattern++)
+            {
+            }
+            lastName = name;
+        }
+        if (lastPattern == library.GetCount())
+        {
+            error = "line " + std::to_string(lineNumber) + ": unknown pattern " + name;
+            return false;
+        }
+        placement.pattern = lastPattern;
+
+        std::string option;
+        while (words >> option)
+        {
+            if (option.size() == 2 && option[0] == 'r' && option[1] >= '0' && option[1] <= '3')
+                placement.orientation = (placement.orientation & PATTERN_MIRROR) | (unsigned int)(option[1] - '0');
+            else if (option == "mirror")
+                placement.orientation |= PATTERN_MIRROR;
+            else if (option == "replace")
+                placement.replace = true;
+            else
+            {
+                error = "line " + std::to_string(lineNumber) + ": unknown option " + option;
+                return false;
+            }
+        }
+        placements.push_back(placement);
+    }
+    return true;
+}
+
+CellRect PatternScript::Apply(Simulation& simulation) const
+{
+    CellRect dirty;
+    for (const PatternPlacement& placement : placements)
+        dirty.Include(simulation.Stamp(library->GetStamp(placement.pattern, placement.orientation), placement.x, placement.y, placement.replace));
+    return dirty;
+}
+
+const std::vector<PatternPlacement>& PatternScript::GetPlacements() const
+{
+    return placements;
+}
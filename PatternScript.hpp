@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Simulation.hpp"
+#include <string>
+#include <vector>
+
+
+struct PatternPlacement
+{
+    size_t pattern;
+    unsigned int orientation;
+    int x, y;
+    bool replace;
+};
+
+// Stamps read from a text file, one per line:
+//   glider 10 20
+//   gosper_glider_gun 100 40 r1 mirror replace
+// rN turns the pattern N quarter turns clockwise, mirror flips it left to right
+// before turning and replace kills the dead cells of its box. # starts a comment.
+class PatternScript
+{
+public:
+    bool Load(const std::string& filePath, const PatternLibrary& library, std::string& error);
+    bool Parse(const std::string& text, const PatternLibrary& library, std::string& error);
+
+    // stamps every placement in order, returns the bounding box of all touched cells
+    CellRect Apply(Simulation& simulation) const;
+
+    const std::vector<PatternPlacement>& GetPlacements() const;
+
+private:
+    const PatternLibrary* library = nullptr;
+    std::vector<PatternPlacement> placements;
+};
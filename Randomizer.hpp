@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <random>
 
 class Randomizer
@@ -20,4 +21,29 @@ public:
 
 private:
     std::mt19937 mersenneTwister;
-};
\ No newline at end of file
+};
+
+// Cheap to seed generator for parallel fills, one independent stream per column
+class SplitMix64
+{
+public:
+    SplitMix64(uint64_t seed, uint64_t stream)
+        : state(Mix(seed ^ Mix(stream + 1)))
+    {
+    }
+
+    uint64_t Next()
+    {
+        return Mix(state += 0x9E3779B97F4A7C15ull);
+    }
+
+    static uint64_t Mix(uint64_t value)
+    {
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+
+private:
+    uint64_t state;
+};
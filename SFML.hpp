@@ -1,10 +1,6 @@
 #pragma once
 
+#include <SFML/Config.hpp>
 #include <SFML/System.hpp>
-#include <SFML/Main.hpp>
-#include <SFML/OpenGL.hpp>
-#include <SFML/Graphics.hpp>
 #include <SFML/Window.hpp>
-#include <SFML/Network.hpp>
-#include <SFML/Audio.hpp>
-#include <SFML/Config.hpp>
\ No newline at end of file
+#include <SFML/Graphics.hpp>
\ No newline at end of file
@@ -2,11 +2,15 @@
 
 const unsigned int RES_X = 1680;
 const unsigned int RES_Y = 1050;
+const unsigned int FIELD_WIDTH = 0; // 0 fits the field to the window
+const unsigned int FIELD_HEIGHT = 0; // 0 fits the field to the window
 const unsigned int MAX_FPS = 100;
 const float CELL_SIZE = 5.f;
 const float CELL_GAP = 1.f;
 const unsigned long long RANDOM_CHANCE = 10ull;
 const unsigned int BLOODY_CELL_RANDOM_CHANCE = 500ull;
+const unsigned long long AUTOSAVE_GENERATIONS = 0ull; // 0 disables
+const float AUTOSAVE_SECONDS = 0.f; // 0 disables
 const sf::Color CELL_ALIVE_COLOR = sf::Color::Green;
 const sf::Color CELL_BLOODY_COLOR = sf::Color::Red;
 const sf::Color CELL_DEAD_COLOR = sf::Color(30, 30, 30);
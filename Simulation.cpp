@@ -0,0 +1,283 @@
+#include "Simulation.hpp"
+#include <ctime>
+#include "FieldFile.hpp"
+#include <algorithm>
+#include <utility>
+
+
+Simulation::Simulation(unsigned int fieldWidth, unsigned int fieldHeight, unsigned long long randomChance, unsigned long long randomChanceBloody)
+    : gameField(fieldWidth, fieldHeight), nextField(fieldWidth, fieldHeight), randomChance(std::max(1ull, randomChance))
+{
+    stepSettings.randomChanceBloody = randomChanceBloody;
+    generation = 0;
+    stable = false;
+
+    randomizer.Seed((unsigned long long)time(nullptr));
+}
+
+unsigned int Simulation::GetWidth() const
+{
+    return gameField.GetWidth();
+}
+
+unsigned int Simulation::GetHeight() const
+{
+    return gameField.GetHeight();
+}
+
+void Simulation::Seed(unsigned long long seed)
+{
+    randomizer.Seed(seed);
+}
+
+void FillRandomColumns(PlaneGrid& grid, unsigned int begin, unsigned int end, unsigned int firstStream, uint64_t seed, unsigned long long randomChance)
+{
+    uint64_t aliveThreshold = UINT64_MAX / std::max(1ull, randomChance);
+
+    // every word is overwritten, so no Clear() pass is needed
+    ParallelFor(begin, end, [&](unsigned int chunkBegin, unsigned int chunkEnd)
+    {
+        unsigned int height = grid.GetHeight();
+        for (unsigned int x = chunkBegin; x < chunkEnd; x++)
+        {
+            SplitMix64 stream(seed, firstStream + (x - begin));
+            uint64_t* alive = grid.AliveColumn(x);
+            uint64_t* bloody = grid.BloodyColumn(x);
+
+            for (size_t i = 0; i < grid.GetWordsPerColumn(); i++)
+            {
+                uint64_t aliveWord = 0, bloodyWord = 0;
+                unsigned int bits = std::min(64u, height - (unsigned int)i * 64);
+                for (unsigned int bit = 0; bit < bits; bit++)
+                {
+                    aliveWord |= (uint64_t)(stream.Next() < aliveThreshold) << bit;
+                    /* enable for bloody cell randomization
+                    if (stream.Next() < aliveThreshold / 20)
+                    {
+                        aliveWord &= ~(1ull << bit);
+                        bloodyWord |= 1ull << bit;
+                    }
+                    */
+                }
+                alive[i] = aliveWord;
+                bloody[i] = bloodyWord;
+            }
+        }
+    }, ColumnsPerChunk(grid.GetHeight()));
+}
+
+void Simulation::Randomize()
+{
+    uint64_t seed = BeginRandomize();
+    RandomizeColumns(0, gameField.GetWidth(), seed);
+}
+
+uint64_t Simulation::BeginRandomize()
+{
+    generation = 0;
+    stable = false;
+    return randomizer.Random<uint64_t>(0, UINT64_MAX);
+}
+
+void Simulation::RandomizeColumns(unsigned int begin, unsigned int end, uint64_t seed)
+{
+    FillRandomColumns(gameField, begin, end, begin, seed, randomChance);
+}
+
+bool Simulation::Load(const std::string& filePath) 
+{
+    std::string text;
+    if(ReadFileText(filePath, text))
+    {
+        DecodeFieldText(text, gameField);
+
+        generation = 0;
+        stable = false;
+        return true;
+    }
+    return false;
+}
+
+bool Simulation::Save(const std::string& filePath) const
+{
+    return WriteFileAtomically(filePath, EncodeFieldText(gameField));
+}
+
+void Simulation::LoadFrame(const PlaneGrid& frame, unsigned long long frameGeneration)
+{
+    if (frame.GetWidth() == gameField.GetWidth() && frame.GetHeight() == gameField.GetHeight())
+        gameField.CopyFrom(frame);
+    else
+    {
+        unsigned int width = std::min(frame.GetWidth(), gameField.GetWidth());
+        unsigned int rows = std::min(frame.GetHeight(), gameField.GetHeight());
+
+        gameField.Clear();
+        ParallelFor(0, width, [&](unsigned int begin, unsigned int end)
+        {
+            for (unsigned int x = begin; x < end; x++)
+            {
+                for (unsigned int y = 0; y < rows; y++)
+                    gameField.Set(x, y, frame.Get(x, y));
+            }
+        }, ColumnsPerChunk(rows));
+    }
+
+    generation = frameGeneration;
+    stable = false;
+}
+
+void Simulation::Clear()
+{
+    gameField.Clear();
+
+    generation = 0;
+    stable = false;
+}
+
+bool Simulation::NextGeneration()
+{
+    if(!stable)
+    {
+        bool changed = StepGeneration(stepSettings, randomizer, gameField, nextField);
+        std::swap(gameField, nextField);
+
+        // A quiet generation is only final when no random draw can change the field later.
+        // Bloody cells may move at random, and after a quiet generation every alive cell
+        // has two or three alive neighbours, so any alive cell may still turn bloody.
+        stable = !changed && (stepSettings.rule != CellRule::Bloody
+            || (CountCells(CELL_BLOODY) == 0 && (stepSettings.randomChanceBloody == 0 || CountCells(CELL_ALIVE) == 0)));
+        if(!stable)
+            generation++;
+        return changed;
+    }
+    return false;
+}
+
+uint8_t Simulation::GetCell(unsigned int x, unsigned int y) const
+{
+    return gameField.Get(x, y);
+}
+
+void Simulation::SetCell(unsigned int x, unsigned int y, uint8_t state)
+{
+    gameField.Set(x, y, state);
+    stable = false;
+}
+
+CellRect Simulation::Stamp(const PatternStamp& stamp, int x, int y, bool replace)
+{
+    CellRect dirty = StampPattern(stamp, gameField, x, y, replace);
+    if (!dirty.IsEmpty())
+        stable = false;
+    return dirty;
+}
+
+CellRect Simulation::Fill(const CellRect& rect, uint8_t state)
+{
+    CellRect dirty = FillCells(gameField, rect, state);
+    if (!dirty.IsEmpty())
+        stable = false;
+    return dirty;
+}
+
+PatternStamp Simulation::Copy(const CellRect& rect) const
+{
+    return CopyPattern(gameField, rect);
+}
+
+const PlaneGrid& Simulation::GetGrid() const
+{
+    return gameField;
+}
+
+std::shared_ptr<const FieldSnapshot> Simulation::TakeSnapshot() const
+{
+    return std::make_shared<const FieldSnapshot>(FieldSnapshot{ gameField, generation });
+}
+
+unsigned long long Simulation::CountCells(uint8_t state) const
+{
+    unsigned long long alive = 0, bloody = 0;
+    for (unsigned int x = 0; x < gameField.GetWidth(); x++)
+    {
+        const uint64_t* aliveColumn = gameField.AliveColumn(x);
+        const uint64_t* bloodyColumn = gameField.BloodyColumn(x);
+        for (size_t i = 0; i < gameField.GetWordsPerColumn(); i++)
+        {
+            alive += PopCount(aliveColumn[i]);
+            bloody += PopCount(bloodyColumn[i]);
+        }
+    }
+
+    if (state == CELL_ALIVE)
+        return alive;
+    if (state == CELL_BLOODY)
+        return bloody;
+    return (unsigned long long)gameField.GetWidth() * gameField.GetHeight() - alive - bloody;
+}
+
+uint64_t Simulation::Hash() const
+{
+    return gameField.Hash();
+}
+
+unsigned long long Simulation::GetGeneration() const 
+{
+    return generation;
+}
+
+bool Simulation::IsStable() const
+{
+    return stable;
+}
+
+void Simulation::SetRandomChance(unsigned long long randomChance)
+{
+    // 1 out of 0 cells has no meaning, 1 fills the whole field
+    this->randomChance = std::max(1ull, randomChance);
+}
+
+unsigned long long Simulation::GetRandomChance() const
+{
+    return randomChance;
+}
+
+void Simulation::SetRandomChanceBloody(unsigned long long randomChanceBloody)
+{
+    stepSettings.randomChanceBloody = randomChanceBloody;
+}
+
+unsigned long long Simulation::GetRandomChanceBloody() const
+{
+    return stepSettings.randomChanceBloody;
+}
+
+void Simulation::SetRule(CellRule rule)
+{
+    stepSettings.rule = rule;
+    stable = false;
+}
+
+CellRule Simulation::GetRule() const
+{
+    return stepSettings.rule;
+}
+
+void Simulation::SetRuleTable(uint16_t birth, uint16_t survive)
+{
+    stepSettings.table.birth = birth;
+    stepSettings.table.survive = survive;
+    stable = false;
+}
+
+void Simulation::SetTopology(FieldTopology topology)
+{
+    stepSettings.topology = topology;
+    stable = false;
+}
+
+FieldTopology Simulation::GetTopology() const
+{
+    return stepSettings.topology;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Randomizer.hpp"
+#include "CellKernels.hpp"
+#include "Parallel.hpp"
+#include "Pattern.hpp"
+#include <memory>
+#include <string>
+
+
+// Copy of the field taken at a generation boundary, shared read-only with I/O threads
+struct FieldSnapshot
+{
+    PlaneGrid grid;
+    unsigned long long generation;
+};
+
+// Fills columns [begin, end) with a random soup, column x draws from stream
+// firstStream + x - begin, so a strip of a field can be filled on its own
+void FillRandomColumns(PlaneGrid& grid, unsigned int begin, unsigned int end, unsigned int firstStream, uint64_t seed, unsigned long long randomChance);
+
+// Field state and stepping without any rendering, shared by the window and the headless tools
+class Simulation
+{
+public:
+    Simulation(unsigned int fieldWidth, unsigned int fieldHeight, unsigned long long randomChance, unsigned long long randomChanceBloody);
+
+    unsigned int GetWidth() const;
+    unsigned int GetHeight() const;
+
+    void Seed(unsigned long long seed);
+    void Randomize();
+    // Randomize() in parts: BeginRandomize() starts a new soup and returns its seed,
+    // RandomizeColumns() fills columns [begin, end) of it. Disjoint ranges can be
+    // filled at the same time and give the same field as Randomize().
+    uint64_t BeginRandomize();
+    void RandomizeColumns(unsigned int begin, unsigned int end, uint64_t seed);
+    bool Load(const std::string& filePath);
+    bool Save(const std::string& filePath) const;
+    // replaces the field with a recorded frame, a frame of another size is clipped or padded with dead cells
+    void LoadFrame(const PlaneGrid& frame, unsigned long long frameGeneration);
+    void Clear();
+    bool NextGeneration();
+
+    uint8_t GetCell(unsigned int x, unsigned int y) const;
+    void SetCell(unsigned int x, unsigned int y, uint8_t state);
+    // blits a pattern with its top left corner at x, y and returns the cells it touched
+    CellRect Stamp(const PatternStamp& stamp, int x, int y, bool replace);
+    CellRect Fill(const CellRect& rect, uint8_t state);
+    PatternStamp Copy(const CellRect& rect) const;
+    const PlaneGrid& GetGrid() const;
+    std::shared_ptr<const FieldSnapshot> TakeSnapshot() const;
+
+    unsigned long long CountCells(uint8_t state) const;
+    uint64_t Hash() const;
+
+    unsigned long long GetGeneration() const;
+    bool IsStable() const;
+
+    // 1 out of randomChance cells starts alive, 0 counts as 1
+    void SetRandomChance(unsigned long long randomChance);
+    unsigned long long GetRandomChance() const;
+
+    void SetRandomChanceBloody(unsigned long long randomChanceBloody);
+    unsigned long long GetRandomChanceBloody() const;
+
+    void SetRule(CellRule rule);
+    CellRule GetRule() const;
+
+    void SetRuleTable(uint16_t birth, uint16_t survive);
+
+    void SetTopology(FieldTopology topology);
+    FieldTopology GetTopology() const;
+
+private:
+    PlaneGrid gameField, nextField;
+    StepSettings stepSettings;
+    Randomizer randomizer;
+    unsigned long long generation, randomChance;
+    bool stable;
+};
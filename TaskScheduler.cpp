@@ -0,0 +1,279 @@
+#include "TaskScheduler.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <utility>
+
+
+void Task::promise_type::FinalAwaiter::await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+{
+    TaskScheduler* scheduler = handle.promise().scheduler;
+    handle.destroy();
+    scheduler->Finished();
+}
+
+Task::Task(std::coroutine_handle<promise_type> handle)
+    : handle(handle)
+{
+}
+
+Task::Task(Task&& other) noexcept
+    : handle(std::exchange(other.handle, nullptr))
+{
+}
+
+Task::~Task()
+{
+    if (handle)
+        handle.destroy();
+}
+
+bool TaskScheduler::ParallelAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    unsigned int count = end - begin;
+    unsigned int chunkCount = std::max(1u, std::min(scheduler.GetThreadCount(), count / std::max(1u, minChunk)));
+    continuation = handle;
+    remaining = chunkCount;
+
+    unsigned int chunkBegin = begin;
+    for (unsigned int i = 0; i + 1 < chunkCount; i++)
+    {
+        unsigned int chunkEnd = begin + (unsigned int)((unsigned long long)count * (i + 1) / chunkCount);
+        scheduler.Spawn(RunChunk(chunkBegin, chunkEnd));
+        chunkBegin = chunkEnd;
+    }
+    function(chunkBegin, end);
+
+    // stays suspended unless every other chunk is done already, the last one resumes it
+    return remaining.fetch_sub(1) != 1;
+}
+
+Task TaskScheduler::ParallelAwaiter::RunChunk(unsigned int chunkBegin, unsigned int chunkEnd)
+{
+    function(chunkBegin, chunkEnd);
+
+    // the awaiter lives in the awaiting task, which may go on as soon as the count drops
+    TaskScheduler& owner = scheduler;
+    std::coroutine_handle<> waiting = continuation;
+    if (remaining.fetch_sub(1) == 1 && !owner.Enqueue(waiting))
+        waiting.resume();
+    co_return;
+}
+
+TaskScheduler::TaskScheduler(unsigned int threadCount)
+    : liveTasks(0), runningWorkers(0), stopping(false)
+{
+    threadCount = std::max(1u, threadCount);
+    runningWorkers = threadCount;
+    for (unsigned int i = 0; i < threadCount; i++)
+        workers.emplace_back(&TaskScheduler::WorkerTask, this);
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    Stop();
+}
+
+void TaskScheduler::Spawn(Task task)
+{
+    std::coroutine_handle<Task::promise_type> handle = std::exchange(task.handle, nullptr);
+    handle.promise().scheduler = this;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        liveTasks++;
+    }
+
+    if (!Enqueue(handle))
+        handle.resume();
+}
+
+TaskScheduler::ScheduleAwaiter TaskScheduler::Schedule()
+{
+    return ScheduleAwaiter{ *this };
+}
+
+TaskScheduler::DelayAwaiter TaskScheduler::Delay(std::chrono::steady_clock::duration delay)
+{
+    return DelayAwaiter{ *this, std::chrono::steady_clock::now() + delay };
+}
+
+TaskScheduler::ParallelAwaiter TaskScheduler::ParallelFor(unsigned int begin, unsigned int end, std::function<void(unsigned int, unsigned int)> function, unsigned int minChunk)
+{
+    return ParallelAwaiter{ *this, begin, end, minChunk, std::move(function), {}, {} };
+}
+
+void TaskScheduler::Stop()
+{
+    std::vector<PauseGate*> openGates;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+        openGates = gates;
+    }
+    taskAvailable.notify_all();
+    for (PauseGate* gate : openGates)
+        gate->Release();
+
+    for (auto& worker : workers)
+    {
+        if (worker.joinable())
+            worker.join();
+    }
+}
+
+bool TaskScheduler::IsStopping() const
+{
+    return stopping;
+}
+
+unsigned int TaskScheduler::GetThreadCount() const
+{
+    return (unsigned int)workers.size();
+}
+
+bool TaskScheduler::Enqueue(std::coroutine_handle<> handle)
+{
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        if (runningWorkers == 0)
+            return false;
+        ready.push_back(handle);
+    }
+    taskAvailable.notify_one();
+    return true;
+}
+
+bool TaskScheduler::AddTimer(std::chrono::steady_clock::time_point deadline, std::coroutine_handle<> handle)
+{
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        if (stopping)
+            return false;
+        timers.push(Timer{ deadline, handle });
+    }
+    // an idle worker may be sleeping until a later deadline
+    taskAvailable.notify_one();
+    return true;
+}
+
+void TaskScheduler::Finished()
+{
+    bool allFinished;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        allFinished = --liveTasks == 0;
+    }
+    if (allFinished && stopping)
+        taskAvailable.notify_all();
+}
+
+void TaskScheduler::WorkerTask()
+{
+    // tasks split their work with co_await ParallelFor() instead of starting threads
+    SerialSection serial;
+    std::unique_lock<std::mutex> lock(stateMutex);
+
+    while (true)
+    {
+        auto now = std::chrono::steady_clock::now();
+        while (!timers.empty() && (stopping || timers.top().deadline <= now))
+        {
+            ready.push_back(timers.top().handle);
+            timers.pop();
+        }
+
+        if (!ready.empty())
+        {
+            std::coroutine_handle<> handle = ready.front();
+            ready.pop_front();
+            lock.unlock();
+            handle.resume();
+            lock.lock();
+            continue;
+        }
+
+        if (stopping && liveTasks == 0)
+        {
+            runningWorkers--;
+            return;
+        }
+
+        if (timers.empty())
+            taskAvailable.wait(lock);
+        else
+            taskAvailable.wait_until(lock, timers.top().deadline);
+    }
+}
+
+void TaskScheduler::AddGate(PauseGate* gate)
+{
+    std::lock_guard<std::mutex> lock(stateMutex);
+    gates.push_back(gate);
+}
+
+void TaskScheduler::RemoveGate(PauseGate* gate)
+{
+    std::lock_guard<std::mutex> lock(stateMutex);
+    gates.erase(std::remove(gates.begin(), gates.end(), gate), gates.end());
+}
+
+PauseGate::PauseGate(TaskScheduler& scheduler, bool open)
+    : scheduler(scheduler), open(open)
+{
+    scheduler.AddGate(this);
+}
+
+PauseGate::~PauseGate()
+{
+    scheduler.RemoveGate(this);
+}
+
+void PauseGate::Open()
+{
+    {
+        std::lock_guard<std::mutex> lock(gateMutex);
+        open = true;
+    }
+    Release();
+}
+
+void PauseGate::Close()
+{
+    std::lock_guard<std::mutex> lock(gateMutex);
+    open = false;
+}
+
+bool PauseGate::IsOpen() const
+{
+    std::lock_guard<std::mutex> lock(gateMutex);
+    return open;
+}
+
+PauseGate::Awaiter PauseGate::Wait()
+{
+    return Awaiter{ *this };
+}
+
+bool PauseGate::Park(std::coroutine_handle<> handle)
+{
+    // Stop() sets the flag before it releases the gates, so nothing is parked after that
+    std::lock_guard<std::mutex> lock(gateMutex);
+    if (open || scheduler.IsStopping())
+        return false;
+    parked.push_back(handle);
+    return true;
+}
+
+void PauseGate::Release()
+{
+    std::vector<std::coroutine_handle<>> released;
+    {
+        std::lock_guard<std::mutex> lock(gateMutex);
+        released.swap(parked);
+    }
+
+    for (std::coroutine_handle<> handle : released)
+    {
+        if (!scheduler.Enqueue(handle))
+            handle.resume();
+    }
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class TaskScheduler;
+class PauseGate;
+
+// Coroutine of one job run by a TaskScheduler. It starts suspended, runs once
+// spawned and is destroyed by the scheduler when it finishes.
+class Task
+{
+public:
+    struct promise_type
+    {
+        struct FinalAwaiter
+        {
+            bool await_ready() noexcept { return false; }
+            void await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+            void await_resume() noexcept {}
+        };
+
+        TaskScheduler* scheduler = nullptr;
+
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    Task(Task&& other) noexcept;
+    Task(Task const &) = delete;
+    void operator=(Task) = delete;
+    // a task that was never spawned is destroyed unrun
+    ~Task();
+
+private:
+    friend class TaskScheduler;
+
+    explicit Task(std::coroutine_handle<promise_type> handle);
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Fixed set of workers resuming coroutines. Tasks suspended on a delay or a
+// closed PauseGate hold no worker, and idle workers sleep until a task is queued
+// or the next delay runs out. A task that blocks its thread holds its worker.
+// ::ParallelFor() runs inline on the workers, tasks split work with co_await ParallelFor().
+class TaskScheduler
+{
+public:
+    struct ScheduleAwaiter
+    {
+        TaskScheduler& scheduler;
+
+        bool await_ready() const { return false; }
+        bool await_suspend(std::coroutine_handle<> handle) { return scheduler.Enqueue(handle); }
+        void await_resume() const {}
+    };
+
+    struct DelayAwaiter
+    {
+        TaskScheduler& scheduler;
+        std::chrono::steady_clock::time_point deadline;
+
+        bool await_ready() const { return scheduler.IsStopping() || deadline <= std::chrono::steady_clock::now(); }
+        bool await_suspend(std::coroutine_handle<> handle) { return scheduler.AddTimer(deadline, handle); }
+        void await_resume() const {}
+    };
+
+    // Splits [begin, end) into one chunk per worker like ::ParallelFor(), chunks smaller
+    // than minChunk are merged. The awaiting task runs the last chunk itself and the
+    // others are queued as tasks, it continues once every chunk is done.
+    struct ParallelAwaiter
+    {
+        TaskScheduler& scheduler;
+        unsigned int begin, end, minChunk;
+        std::function<void(unsigned int, unsigned int)> function;
+        std::atomic<unsigned int> remaining;
+        std::coroutine_handle<> continuation;
+
+        bool await_ready() const { return end <= begin; }
+        bool await_suspend(std::coroutine_handle<> handle);
+        void await_resume() const {}
+
+        Task RunChunk(unsigned int chunkBegin, unsigned int chunkEnd);
+    };
+
+    explicit TaskScheduler(unsigned int threadCount = std::thread::hardware_concurrency());
+    TaskScheduler(TaskScheduler const &) = delete;
+    void operator=(TaskScheduler) = delete;
+    ~TaskScheduler();
+
+    // queues the task on a worker, once the workers are gone it runs on the caller
+    void Spawn(Task task);
+
+    // co_await Schedule() continues on a worker, co_await Delay() after the delay
+    ScheduleAwaiter Schedule();
+    DelayAwaiter Delay(std::chrono::steady_clock::duration delay);
+    // co_await ParallelFor() runs function(chunkBegin, chunkEnd) on the workers, see ParallelAwaiter
+    ParallelAwaiter ParallelFor(unsigned int begin, unsigned int end, std::function<void(unsigned int, unsigned int)> function, unsigned int minChunk = 16);
+
+    // Running tasks see IsStopping(), pending delays end at once and every gate lets
+    // its parked tasks through. Returns when every task has finished and the workers
+    // are joined, tasks spawned later run inline.
+    void Stop();
+    bool IsStopping() const;
+
+    unsigned int GetThreadCount() const;
+
+private:
+    friend class Task;
+    friend class PauseGate;
+
+    struct Timer
+    {
+        std::chrono::steady_clock::time_point deadline;
+        std::coroutine_handle<> handle;
+
+        bool operator>(const Timer& other) const { return deadline > other.deadline; }
+    };
+
+    // false if no worker is left, the caller resumes the handle itself then
+    bool Enqueue(std::coroutine_handle<> handle);
+    // false if the scheduler is stopping, the delay is skipped then
+    bool AddTimer(std::chrono::steady_clock::time_point deadline, std::coroutine_handle<> handle);
+    void Finished();
+    void WorkerTask();
+    void AddGate(PauseGate* gate);
+    void RemoveGate(PauseGate* gate);
+
+    std::mutex stateMutex;
+    std::condition_variable taskAvailable;
+    std::deque<std::coroutine_handle<>> ready;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    size_t liveTasks;
+    unsigned int runningWorkers;
+    std::atomic<bool> stopping;
+    std::vector<PauseGate*> gates;
+
+    std::vector<std::thread> workers;
+};
+
+// Parks tasks while closed and hands them back to the scheduler when opened or
+// when the scheduler stops. Usage: co_await gate.Wait();
+class PauseGate
+{
+public:
+    struct Awaiter
+    {
+        PauseGate& gate;
+
+        bool await_ready() const { return gate.IsOpen(); }
+        bool await_suspend(std::coroutine_handle<> handle) { return gate.Park(handle); }
+        void await_resume() const {}
+    };
+
+    explicit PauseGate(TaskScheduler& scheduler, bool open = false);
+    PauseGate(PauseGate const &) = delete;
+    void operator=(PauseGate) = delete;
+    ~PauseGate();
+
+    void Open();
+    void Close();
+    bool IsOpen() const;
+
+    Awaiter Wait();
+
+private:
+    friend class TaskScheduler;
+
+    // false if the gate opened or the scheduler stopped meanwhile
+    bool Park(std::coroutine_handle<> handle);
+    void Release();
+
+    TaskScheduler& scheduler;
+    mutable std::mutex gateMutex;
+    bool open;
+    std::vector<std::coroutine_handle<>> parked;
+};
@@ -0,0 +1,341 @@
+#include "Verifier.hpp"
+#include "FieldFile.hpp"
+#include "Simulation.hpp"
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+namespace
+{
+    const int NEIGHBOUR_OFFSETS[8][2] = { { -1,-1 },{ 0,-1 },{ 1,-1 },{ -1,0 },{ 1,0 },{ -1,1 },{ 0,1 },{ 1,1 } };
+
+    // FNV over the cell states in scan order, so any two engines hash alike
+    template <typename Engine>
+    uint64_t HashCells(const Engine& engine, unsigned int width, unsigned int height)
+    {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (unsigned int x = 0; x < width; x++)
+        {
+            for (unsigned int y = 0; y < height; y++)
+                hash = (hash ^ engine.Get(x, y)) * 0x100000001B3ull;
+        }
+        return hash;
+    }
+
+    template <typename Grid>
+    class GridEngine : public CandidateEngine
+    {
+    public:
+        GridEngine(const StepSettings& settings, unsigned long long seed, const PlaneGrid& field)
+            : settings(settings), current(field.GetWidth(), field.GetHeight()), next(field.GetWidth(), field.GetHeight())
+        {
+            for (unsigned int x = 0; x < field.GetWidth(); x++)
+            {
+                for (unsigned int y = 0; y < field.GetHeight(); y++)
+                    current.Set(x, y, field.Get(x, y));
+            }
+            randomizer.Seed(seed);
+        }
+
+        void Step() override
+        {
+            StepGeneration(settings, randomizer, current, next);
+            std::swap(current, next);
+        }
+
+        uint8_t Get(unsigned int x, unsigned int y) const override { return current.Get(x, y); }
+
+    private:
+        StepSettings settings;
+        Randomizer randomizer;
+        Grid current, next;
+    };
+
+    // the full Simulation, including its stop once a generation changes nothing
+    class SimulationEngine : public CandidateEngine
+    {
+    public:
+        SimulationEngine(const StepSettings& settings, unsigned long long seed, const PlaneGrid& field)
+            : simulation(field.GetWidth(), field.GetHeight(), 1, settings.randomChanceBloody)
+        {
+            simulation.SetRule(settings.rule);
+            simulation.SetRuleTable(settings.table.birth, settings.table.survive);
+            simulation.SetTopology(settings.topology);
+            simulation.LoadFrame(field, 0);
+            simulation.Seed(seed);
+        }
+
+        void Step() override { simulation.NextGeneration(); }
+
+        uint8_t Get(unsigned int x, unsigned int y) const override { return simulation.GetCell(x, y); }
+
+    private:
+        Simulation simulation;
+    };
+}
+
+ReferenceEngine::ReferenceEngine(unsigned int width, unsigned int height)
+    : width(width), height(height), cells((size_t)width * height, CELL_DEAD), next((size_t)width * height, CELL_DEAD)
+{
+}
+
+bool ReferenceEngine::Resolve(FieldTopology topology, int& x, int& y) const
+{
+    if (topology == FieldTopology::Torus)
+    {
+        x = (x + (int)width) % (int)width;
+        y = (y + (int)height) % (int)height;
+        return true;
+    }
+    return x >= 0 && y >= 0 && x < (int)width && y < (int)height;
+}
+
+unsigned int ReferenceEngine::CountAlive(FieldTopology topology, unsigned int x, unsigned int y) const
+{
+    unsigned int count = 0;
+    for (const auto& offset : NEIGHBOUR_OFFSETS)
+    {
+        int neighbourX = (int)x + offset[0], neighbourY = (int)y + offset[1];
+        if (Resolve(topology, neighbourX, neighbourY) && Get(neighbourX, neighbourY) == CELL_ALIVE)
+            count++;
+    }
+    return count;
+}
+
+void ReferenceEngine::Step(const StepSettings& settings, Randomizer& randomizer)
+{
+    FieldTopology topology = settings.topology;
+    uint16_t birth = 1 << 3, survive = (1 << 2) | (1 << 3);
+    if (settings.rule == CellRule::Table)
+    {
+        birth = settings.table.birth;
+        survive = settings.table.survive;
+    }
+
+    if (settings.rule != CellRule::Bloody)
+    {
+        // bloody cells count as dead under two-state rules
+        for (unsigned int x = 0; x < width; x++)
+        {
+            for (unsigned int y = 0; y < height; y++)
+            {
+                uint16_t table = Get(x, y) == CELL_ALIVE ? survive : birth;
+                next[(size_t)x * height + y] = ((table >> CountAlive(topology, x, y)) & 1) ? CELL_ALIVE : CELL_DEAD;
+            }
+        }
+        cells.swap(next);
+        return;
+    }
+
+    // Bloody: cells are updated in place in column order, neighbours are counted
+    // on the previous generation and the random stream is drawn in that order
+    next = cells;
+    auto at = [&](int x, int y) -> uint8_t& { return next[(size_t)x * height + y]; };
+    for (unsigned int x = 0; x < width; x++)
+    {
+        for (unsigned int y = 0; y < height; y++)
+        {
+            unsigned int aliveNeighbours = CountAlive(topology, x, y);
+
+            if (at(x, y) == CELL_BLOODY)
+            {
+                // the first alive neighbour of the previous generation is the prey,
+                // without one the cell moves in a random direction
+                int targetX = (int)x, targetY = (int)y;
+                bool found = false;
+                for (const auto& offset : NEIGHBOUR_OFFSETS)
+                {
+                    int neighbourX = (int)x + offset[0], neighbourY = (int)y + offset[1];
+                    if (Resolve(topology, neighbourX, neighbourY) && Get(neighbourX, neighbourY) == CELL_ALIVE)
+                    {
+                        targetX = neighbourX;
+                        targetY = neighbourY;
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found)
+                {
+                    int direction = randomizer.Random<int>(0, 7);
+                    int moveX = (int)x + NEIGHBOUR_OFFSETS[direction][0], moveY = (int)y + NEIGHBOUR_OFFSETS[direction][1];
+                    if (Resolve(topology, moveX, moveY))
+                    {
+                        targetX = moveX;
+                        targetY = moveY;
+                    }
+                }
+
+                if (at(targetX, targetY) == CELL_ALIVE)
+                    at(targetX, targetY) = CELL_BLOODY;
+                else if (at(targetX, targetY) == CELL_DEAD)
+                    at(x, y) = CELL_DEAD;
+            }
+
+            uint8_t cell = at(x, y);
+            if (cell == CELL_ALIVE && (aliveNeighbours < 2 || aliveNeighbours > 3))
+                at(x, y) = CELL_DEAD;
+            else if (cell == CELL_DEAD && aliveNeighbours == 3)
+                at(x, y) = CELL_ALIVE;
+            else if (cell == CELL_ALIVE && settings.randomChanceBloody != 0)
+            {
+                if (randomizer.Random<unsigned long long>(1, settings.randomChanceBloody) == 1)
+                    at(x, y) = CELL_BLOODY;
+            }
+        }
+    }
+    cells.swap(next);
+}
+
+std::unique_ptr<CandidateEngine> CreateEngine(const std::string& name, const StepSettings& settings, unsigned long long seed, const PlaneGrid& field)
+{
+    if (name == "byte")
+        return std::make_unique<GridEngine<ByteGrid>>(settings, seed, field);
+    if (name == "bit" && settings.rule != CellRule::Bloody)
+        return std::make_unique<GridEngine<BitGrid>>(settings, seed, field);
+    if (name == "plane")
+        return std::make_unique<GridEngine<PlaneGrid>>(settings, seed, field);
+    if (name == "simulation")
+        return std::make_unique<SimulationEngine>(settings, seed, field);
+    return nullptr;
+}
+
+std::vector<EngineReport> VerifyEngines(const StepSettings& settings, unsigned long long seed, const PlaneGrid& field, unsigned long long generations,
+    const std::vector<std::string>& engines, unsigned long long& population, double& referenceMilliseconds)
+{
+    unsigned int width = field.GetWidth(), height = field.GetHeight();
+
+    ReferenceEngine reference(width, height);
+    for (unsigned int x = 0; x < width; x++)
+    {
+        for (unsigned int y = 0; y < height; y++)
+            reference.Set(x, y, field.Get(x, y));
+    }
+    Randomizer randomizer;
+    randomizer.Seed(seed);
+
+    std::vector<EngineReport> reports(engines.size());
+    std::vector<std::unique_ptr<CandidateEngine>> candidates;
+    for (size_t i = 0; i < engines.size(); i++)
+    {
+        reports[i].engine = engines[i];
+        candidates.push_back(CreateEngine(engines[i], settings, seed, field));
+        reports[i].skipped = candidates.back() == nullptr;
+    }
+
+    referenceMilliseconds = 0.0;
+    for (unsigned long long generation = 1; generation <= generations; generation++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        reference.Step(settings, randomizer);
+        referenceMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        uint64_t expected = HashCells(reference, width, height);
+
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            EngineReport& report = reports[i];
+            if (report.skipped || report.diverged)
+                continue;
+
+            start = std::chrono::steady_clock::now();
+            candidates[i]->Step();
+            report.milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (HashCells(*candidates[i], width, height) == expected)
+                continue;
+
+            // first cell in scan order that differs
+            report.diverged = true;
+            report.generation = generation;
+            for (unsigned int x = 0; x < width && report.state == report.expected; x++)
+            {
+                for (unsigned int y = 0; y < height; y++)
+                {
+                    if (candidates[i]->Get(x, y) != reference.Get(x, y))
+                    {
+                        report.x = x;
+                        report.y = y;
+                        report.state = candidates[i]->Get(x, y);
+                        report.expected = reference.Get(x, y);
+                        break;
+                    }
+                }
+            }
+            candidates[i].reset();
+        }
+    }
+
+    population = 0;
+    for (unsigned int x = 0; x < width; x++)
+    {
+        for (unsigned int y = 0; y < height; y++)
+            population += reference.Get(x, y) == CELL_ALIVE;
+    }
+    return reports;
+}
+
+bool LoadGoldenManifest(const std::string& filePath, std::vector<GoldenEntry>& entries, std::string& error)
+{
+    std::ifstream file(filePath);
+    if (!file.is_open())
+    {
+        error = "can't open " + filePath;
+        return false;
+    }
+
+    entries.clear();
+    std::string line;
+    unsigned int lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+        std::istringstream words(line.substr(0, line.find('#')));
+        GoldenEntry entry;
+        std::string size, rule, topology;
+        if (!(words >> entry.pattern))
+            continue;
+
+        entry.line = lineNumber;
+        if (!(words >> size >> rule >> topology >> entry.generation >> entry.population) || !ParseSize(size, entry.width, entry.height) || entry.width == 0 || entry.height == 0)
+        {
+            error = "line " + std::to_string(lineNumber) + ": expected pattern WxH rule topology generation population";
+            return false;
+        }
+
+        entry.settings.rule = CellRule::Classic;
+        if (rule.compare(0, 7, "bloody:") == 0 && rule.size() > 7 && rule.find_first_not_of("0123456789", 7) == std::string::npos)
+        {
+            entry.settings.rule = CellRule::Bloody;
+            entry.settings.randomChanceBloody = std::stoull(rule.substr(7));
+        }
+        else if (rule != "classic")
+        {
+            if (!TableRule::Parse(rule, entry.settings.table))
+            {
+                error = "line " + std::to_string(lineNumber) + ": unknown rule " + rule;
+                return false;
+            }
+            entry.settings.rule = CellRule::Table;
+        }
+
+        if (topology != "deadedge" && topology != "torus")
+        {
+            error = "line " + std::to_string(lineNumber) + ": unknown topology " + topology;
+            return false;
+        }
+        entry.settings.topology = topology == "torus" ? FieldTopology::Torus : FieldTopology::DeadEdge;
+
+        std::string expectation;
+        entry.stable = false;
+        if (words >> expectation)
+        {
+            if (expectation != "stable")
+            {
+                error = "line " + std::to_string(lineNumber) + ": unknown expectation " + expectation;
+                return false;
+            }
+            entry.stable = true;
+        }
+        entries.push_back(entry);
+    }
+    return true;
+}
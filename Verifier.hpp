@@ -0,0 +1,80 @@
+#pragma once
+
+#include "CellKernels.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+
+// Naive engine the fast kernels are checked against: one byte per cell, every
+// neighbour resolved through the topology and the rules written out cell by cell.
+class ReferenceEngine
+{
+public:
+    ReferenceEngine(unsigned int width, unsigned int height);
+
+    unsigned int GetWidth() const { return width; }
+    unsigned int GetHeight() const { return height; }
+
+    uint8_t Get(unsigned int x, unsigned int y) const { return cells[(size_t)x * height + y]; }
+    void Set(unsigned int x, unsigned int y, uint8_t state) { cells[(size_t)x * height + y] = state; }
+
+    void Step(const StepSettings& settings, Randomizer& randomizer);
+
+private:
+    // false if x, y falls off a dead edge, otherwise wraps it on a torus
+    bool Resolve(FieldTopology topology, int& x, int& y) const;
+    unsigned int CountAlive(FieldTopology topology, unsigned int x, unsigned int y) const;
+
+    unsigned int width, height;
+    std::vector<uint8_t> cells, next;
+};
+
+// A candidate engine stepped next to the reference, see CreateEngine()
+class CandidateEngine
+{
+public:
+    virtual ~CandidateEngine() {}
+
+    virtual void Step() = 0;
+    virtual uint8_t Get(unsigned int x, unsigned int y) const = 0;
+};
+
+// "byte", "bit", "plane" or "simulation", nullptr for an unknown name or when the
+// engine can't run the rule (bit grids have no bloody cells)
+std::unique_ptr<CandidateEngine> CreateEngine(const std::string& name, const StepSettings& settings, unsigned long long seed, const PlaneGrid& field);
+
+struct EngineReport
+{
+    std::string engine;
+    bool skipped = false;
+    bool diverged = false;
+    // first generation and cell where the engine disagrees with the reference
+    unsigned long long generation = 0;
+    unsigned int x = 0, y = 0;
+    uint8_t state = 0, expected = 0;
+    double milliseconds = 0.0;
+};
+
+// Steps the reference and every engine in lockstep from field, the random streams
+// are all seeded with seed. Hashes are compared after every generation and a
+// diverged engine is dropped. population is the reference population at the end.
+std::vector<EngineReport> VerifyEngines(const StepSettings& settings, unsigned long long seed, const PlaneGrid& field, unsigned long long generations,
+    const std::vector<std::string>& engines, unsigned long long& population, double& referenceMilliseconds);
+
+// One line of a golden manifest: a pattern centered on an empty field and the
+// population it is known to have at a generation. With stable set a Simulation
+// also has to call the field stable by then.
+struct GoldenEntry
+{
+    std::string pattern;
+    unsigned int width, height;
+    StepSettings settings;
+    unsigned long long generation, population;
+    bool stable;
+    unsigned int line;
+};
+
+// Lines are "pattern WxH rule topology generation population [stable]", rule is
+// classic, bloody:N with 1 out of N cells turning bloody, or a B/S table. # starts a comment.
+bool LoadGoldenManifest(const std::string& filePath, std::vector<GoldenEntry>& entries, std::string& error);
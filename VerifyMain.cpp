@@ -0,0 +1,381 @@
+#include "FieldFile.hpp"
+#include "Simulation.hpp"
+#include "Verifier.hpp"
+#ifndef _WIN32
+#include "DistributedRunner.hpp"
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+// Steps a naive reference engine and the fast engines in lockstep from the same
+// field and seed, and reports the first cell where an engine disagrees.
+// Usage: gol_verify [--size WxH] [--load FILE | --pattern FILE] [--random N] [--bloody N]
+//                   [--start-bloody N] [--seed N] [--rule classic|bloody|table] [--table B3/S23]
+//                   [--topology deadedge|torus] [--generations N] [--engines byte,bit,plane,simulation]
+//        gol_verify --golden DIR
+//        gol_verify --distributed 1,2,3 [--size WxH] [--load FILE] [--random N] [--seed N] [--rule ...]
+// --start-bloody turns 1 out of N alive cells of a random soup bloody, 0 disables.
+// --golden runs every entry of DIR/manifest.txt through all engines.
+// --distributed steps the field split into strips for each process count and
+// compares it with a single Simulation, on both topologies unless --topology is
+// given. Not on Windows.
+
+const unsigned int VERIFY_DEFAULT_WIDTH = 256;
+const unsigned int VERIFY_DEFAULT_HEIGHT = 256;
+const unsigned long long VERIFY_DEFAULT_RANDOM_CHANCE = 4ull;
+const unsigned long long VERIFY_DEFAULT_BLOODY_CHANCE = 500ull;
+const unsigned long long VERIFY_DEFAULT_START_BLOODY = 20ull;
+const unsigned long long VERIFY_DEFAULT_GENERATIONS = 500ull;
+const std::string VERIFY_ENGINES = "byte,bit,plane,simulation";
+const std::string VERIFY_DISTRIBUTED_PROCESSES = "1,2,3,4,7";
+const std::string GOLDEN_MANIFEST_FILE = "manifest.txt";
+
+void PrintUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [--size WxH] [--load FILE | --pattern FILE] [--random N] [--bloody N]\n"
+        << "       [--start-bloody N] [--seed N] [--rule classic|bloody|table] [--table B3/S23]\n"
+        << "       [--topology deadedge|torus] [--generations N] [--engines " << VERIFY_ENGINES << "]\n"
+        << "       " << program << " --golden DIR\n"
+        << "       " << program << " --distributed " << VERIFY_DISTRIBUTED_PROCESSES << " [--size WxH] [--load FILE] [--random N] [--seed N] [--rule ...]\n";
+}
+
+std::vector<std::string> SplitList(const std::string& text)
+{
+    std::vector<std::string> engines;
+    for (size_t start = 0; start <= text.size();)
+    {
+        size_t end = std::min(text.find(',', start), text.size());
+        if (end > start)
+            engines.push_back(text.substr(start, end - start));
+        start = end + 1;
+    }
+    return engines;
+}
+
+// the pattern is centered on an empty field
+bool LoadPatternField(const std::string& filePath, PlaneGrid& field)
+{
+    std::string text;
+    PatternStamp stamp;
+    if (!ReadFileText(filePath, text) || !ParsePattern(text, std::filesystem::path(filePath).extension().string(), stamp))
+        return false;
+
+    field.Clear();
+    StampPattern(stamp, field, ((int)field.GetWidth() - (int)stamp.width) / 2, ((int)field.GetHeight() - (int)stamp.height) / 2, true);
+    return true;
+}
+
+// prints one line per engine, false if any engine diverged
+bool PrintReports(const std::vector<EngineReport>& reports, double referenceMilliseconds)
+{
+    bool agreed = true;
+    std::cout << "  reference: " << referenceMilliseconds << " ms\n";
+    for (const EngineReport& report : reports)
+    {
+        std::cout << "  " << report.engine << ": ";
+        if (report.skipped)
+            std::cout << "skipped, unknown engine or rule it can't run\n";
+        else if (report.diverged)
+        {
+            std::cout << "DIVERGED at generation " << report.generation << ", cell " << report.x << "," << report.y
+                << " is " << (int)report.state << ", reference " << (int)report.expected << "\n";
+            agreed = false;
+        }
+        else
+            std::cout << "ok, " << report.milliseconds << " ms\n";
+    }
+    return agreed;
+}
+
+// whether a Simulation started on field calls it stable within generations
+bool IsStableBy(const StepSettings& settings, const PlaneGrid& field, unsigned long long generations)
+{
+    Simulation simulation(field.GetWidth(), field.GetHeight(), VERIFY_DEFAULT_RANDOM_CHANCE, settings.randomChanceBloody);
+    simulation.SetRule(settings.rule);
+    simulation.SetRuleTable(settings.table.birth, settings.table.survive);
+    simulation.SetTopology(settings.topology);
+    simulation.Seed(0);
+    simulation.LoadFrame(field, 0);
+
+    for (unsigned long long generation = 0; generation < generations && !simulation.IsStable(); generation++)
+        simulation.NextGeneration();
+    return simulation.IsStable();
+}
+
+int RunGolden(const std::string& directory)
+{
+    std::vector<GoldenEntry> entries;
+    std::string error;
+    if (!LoadGoldenManifest((std::filesystem::path(directory) / GOLDEN_MANIFEST_FILE).string(), entries, error))
+    {
+        std::cerr << "Error in golden manifest: " << error << "\n";
+        return 1;
+    }
+
+    unsigned int failures = 0;
+    for (const GoldenEntry& entry : entries)
+    {
+        PlaneGrid field(entry.width, entry.height);
+        if (!LoadPatternField((std::filesystem::path(directory) / entry.pattern).string(), field))
+        {
+            std::cerr << "Error loading pattern " << entry.pattern << " (line " << entry.line << ")\n";
+            failures++;
+            continue;
+        }
+
+        unsigned long long population;
+        double referenceMilliseconds;
+        std::vector<EngineReport> reports = VerifyEngines(entry.settings, 0, field, entry.generation, SplitList(VERIFY_ENGINES), population, referenceMilliseconds);
+
+        bool matched = population == entry.population;
+        std::cout << entry.pattern << " " << entry.width << "x" << entry.height << ": generation " << entry.generation
+            << ", population " << population << (matched ? "" : ", EXPECTED " + std::to_string(entry.population));
+        if (entry.stable)
+        {
+            bool stable = IsStableBy(entry.settings, field, entry.generation);
+            std::cout << (stable ? ", stable" : ", NOT STABLE");
+            matched = matched && stable;
+        }
+        std::cout << "\n";
+        if (!PrintReports(reports, referenceMilliseconds) || !matched)
+            failures++;
+    }
+
+    std::cout << entries.size() - failures << " of " << entries.size() << " golden entries passed\n";
+    return failures == 0 ? 0 : 1;
+}
+
+#ifndef _WIN32
+// Strips have to match the single process field for every process count, the
+// bloody rule has to be refused on more than one process, see DistributedSpec.
+int RunDistributed(const DistributedSpec& baseSpec, const std::vector<unsigned int>& processCounts)
+{
+    Simulation simulation(baseSpec.width, baseSpec.height, baseSpec.randomChance, baseSpec.settings.randomChanceBloody);
+    simulation.SetRule(baseSpec.settings.rule);
+    simulation.SetRuleTable(baseSpec.settings.table.birth, baseSpec.settings.table.survive);
+    simulation.SetTopology(baseSpec.settings.topology);
+    simulation.Seed(baseSpec.seed);
+    if (baseSpec.loadPath == "")
+        simulation.Randomize();
+    else if (!simulation.Load(baseSpec.loadPath))
+    {
+        std::cerr << "Error loading field " << baseSpec.loadPath << "\n";
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long long generation = 0; generation < baseSpec.generations; generation++)
+        simulation.NextGeneration();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << baseSpec.width << "x" << baseSpec.height << (baseSpec.settings.topology == FieldTopology::Torus ? " torus" : " dead edge")
+        << ", seed " << baseSpec.seed << ": generation " << baseSpec.generations
+        << ", population " << simulation.CountCells(CELL_ALIVE) << "\n"
+        << "  single process: " << elapsed.count() << " ms\n";
+
+    std::string savePath = (std::filesystem::temp_directory_path() / ("gol_verify_" + std::to_string(getpid()) + ".txt")).string();
+    bool agreed = true;
+    for (unsigned int processCount : processCounts)
+    {
+        DistributedSpec spec = baseSpec;
+        spec.processCount = processCount;
+        spec.savePath = savePath;
+        std::cout << "  " << spec.processCount << " processes: ";
+        DistributedResult result;
+        std::string error;
+        if (spec.settings.rule == CellRule::Bloody && spec.processCount > 1)
+        {
+            bool refused = !DistributedRunner(spec).Run(result, error);
+            std::cout << (refused ? "ok, refused: " + error : "FAILED, the bloody rule ran on several processes") << "\n";
+            agreed = agreed && refused;
+            continue;
+        }
+
+        Simulation strips(spec.width, spec.height, spec.randomChance, spec.settings.randomChanceBloody);
+        if (!DistributedRunner(spec).Run(result, error) || !strips.Load(savePath))
+        {
+            std::cout << "FAILED, " << (error != "" ? error : "can't load " + savePath) << "\n";
+            agreed = false;
+            continue;
+        }
+
+        // text field files don't tell bloody cells apart, they come back alive
+        const PlaneGrid& actual = strips.GetGrid();
+        bool matched = true;
+        for (unsigned int x = 0; x < spec.width && matched; x++)
+        {
+            for (unsigned int y = 0; y < spec.height && matched; y++)
+            {
+                uint8_t expected = simulation.GetCell(x, y) != CELL_DEAD ? CELL_ALIVE : CELL_DEAD;
+                if (actual.Get(x, y) != expected)
+                {
+                    std::cout << "DIFFERS at cell " << x << "," << y << ", it is " << (int)actual.Get(x, y) << ", single process " << (int)expected << "\n";
+                    matched = false;
+                }
+            }
+        }
+        if (matched)
+            std::cout << "ok, " << result.stepMilliseconds + result.waitMilliseconds << " ms\n";
+        agreed = agreed && matched;
+    }
+
+    std::filesystem::remove(savePath);
+    return agreed ? 0 : 1;
+}
+#endif
+
+int main(int argc, char* argv[])
+{
+    unsigned int width = VERIFY_DEFAULT_WIDTH, height = VERIFY_DEFAULT_HEIGHT;
+    unsigned long long randomChance = VERIFY_DEFAULT_RANDOM_CHANCE, startBloody = VERIFY_DEFAULT_START_BLOODY;
+    unsigned long long seed = (unsigned long long)time(nullptr), generations = VERIFY_DEFAULT_GENERATIONS;
+    std::string loadPath, patternPath, goldenPath, engines = VERIFY_ENGINES;
+    std::vector<unsigned int> processCounts;
+    StepSettings settings;
+    bool topologyGiven = false;
+    settings.randomChanceBloody = VERIFY_DEFAULT_BLOODY_CHANCE;
+
+    try
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string option = argv[i];
+            if (i + 1 >= argc)
+            {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            std::string value = argv[++i];
+
+            if (option == "--size")
+            {
+                if (!ParseSize(value, width, height))
+                {
+                    std::cerr << "Error: --size expects WxH, got " << value << "\n";
+                    return 1;
+                }
+            }
+            else if (option == "--load")
+                loadPath = value;
+            else if (option == "--pattern")
+                patternPath = value;
+            else if (option == "--golden")
+                goldenPath = value;
+            else if (option == "--distributed")
+            {
+                for (const std::string& count : SplitList(value))
+                    processCounts.push_back(std::max(1u, (unsigned int)std::stoul(count)));
+            }
+            else if (option == "--engines")
+                engines = value;
+            else if (option == "--random")
+                randomChance = std::max(1ull, std::stoull(value));
+            else if (option == "--bloody")
+                settings.randomChanceBloody = std::stoull(value);
+            else if (option == "--start-bloody")
+                startBloody = std::stoull(value);
+            else if (option == "--seed")
+                seed = std::stoull(value);
+            else if (option == "--generations")
+                generations = std::stoull(value);
+            else if (option == "--rule" && (value == "classic" || value == "bloody" || value == "table"))
+                settings.rule = value == "classic" ? CellRule::Classic : (value == "table" ? CellRule::Table : CellRule::Bloody);
+            else if (option == "--table" && TableRule::Parse(value, settings.table))
+                settings.rule = CellRule::Table;
+            else if (option == "--topology" && (value == "deadedge" || value == "torus"))
+            {
+                settings.topology = value == "torus" ? FieldTopology::Torus : FieldTopology::DeadEdge;
+                topologyGiven = true;
+            }
+            else
+            {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception&)
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    if (goldenPath != "")
+        return RunGolden(goldenPath);
+
+    if (!processCounts.empty())
+    {
+#ifndef _WIN32
+        DistributedSpec spec;
+        spec.width = width;
+        spec.height = height;
+        spec.generations = generations;
+        spec.seed = seed;
+        spec.randomChance = randomChance;
+        spec.settings = settings;
+        spec.loadPath = loadPath;
+
+        std::vector<FieldTopology> topologies = { FieldTopology::DeadEdge, FieldTopology::Torus };
+        if (topologyGiven)
+            topologies = { settings.topology };
+        int exitCode = 0;
+        for (FieldTopology topology : topologies)
+        {
+            spec.settings.topology = topology;
+            exitCode = std::max(exitCode, RunDistributed(spec, processCounts));
+        }
+        return exitCode;
+#else
+        std::cerr << "--distributed needs fork(), it is not available on Windows\n";
+        return 1;
+#endif
+    }
+
+    Simulation simulation(width, height, randomChance, settings.randomChanceBloody);
+    simulation.Seed(seed);
+    PlaneGrid field(width, height);
+    if (loadPath != "")
+    {
+        if (!simulation.Load(loadPath))
+        {
+            std::cerr << "Error loading field " << loadPath << "\n";
+            return 1;
+        }
+        field = simulation.GetGrid();
+    }
+    else if (patternPath != "")
+    {
+        if (!LoadPatternField(patternPath, field))
+        {
+            std::cerr << "Error loading pattern " << patternPath << "\n";
+            return 1;
+        }
+    }
+    else
+    {
+        // soups start with some bloody cells so the hunting code runs from the first generation
+        simulation.Randomize();
+        field = simulation.GetGrid();
+        for (unsigned int x = 0; x < width && startBloody > 0; x++)
+        {
+            SplitMix64 stream(seed, x);
+            for (unsigned int y = 0; y < height; y++)
+            {
+                if (stream.Next() % startBloody == 0 && field.Get(x, y) == CELL_ALIVE)
+                    field.Set(x, y, CELL_BLOODY);
+            }
+        }
+    }
+
+    unsigned long long population;
+    double referenceMilliseconds;
+    std::vector<EngineReport> reports = VerifyEngines(settings, seed, field, generations, SplitList(engines), population, referenceMilliseconds);
+
+    std::cout << width << "x" << height << ", seed " << seed << ": generation " << generations << ", population " << population << "\n";
+    return PrintReports(reports, referenceMilliseconds) ? 0 : 1;
+}
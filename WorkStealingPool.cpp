@@ -0,0 +1,120 @@
+#include "WorkStealingPool.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+
+namespace
+{
+    thread_local const WorkStealingPool* currentPool = nullptr;
+    thread_local unsigned int currentWorker = 0;
+}
+
+WorkStealingPool::WorkStealingPool(unsigned int threadCount)
+    : queuedTasks(0), unfinishedTasks(0), nextQueue(0), stopping(false)
+{
+    threadCount = std::max(1u, threadCount);
+
+    for (unsigned int i = 0; i < threadCount; i++)
+        queues.push_back(std::make_unique<WorkerQueue>());
+    for (unsigned int i = 0; i < threadCount; i++)
+        workers.emplace_back(&WorkStealingPool::WorkerTask, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    Wait();
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+void WorkStealingPool::Submit(std::function<void()> task)
+{
+    unsigned int queue;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        queue = currentPool == this ? currentWorker : nextQueue++ % (unsigned int)queues.size();
+        unfinishedTasks++;
+        queuedTasks++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[queue]->mutex);
+        queues[queue]->tasks.push_back(std::move(task));
+    }
+    taskAvailable.notify_one();
+}
+
+void WorkStealingPool::Wait()
+{
+    std::unique_lock<std::mutex> lock(stateMutex);
+    allDone.wait(lock, [this]() { return unfinishedTasks == 0; });
+}
+
+unsigned int WorkStealingPool::GetThreadCount() const
+{
+    return (unsigned int)workers.size();
+}
+
+bool WorkStealingPool::TryPop(unsigned int worker, std::function<void()>& task)
+{
+    {
+        WorkerQueue& own = *queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < queues.size(); i++)
+    {
+        WorkerQueue& victim = *queues[(worker + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::WorkerTask(unsigned int worker)
+{
+    currentPool = this;
+    currentWorker = worker;
+    // one task per worker already fills the cores, tasks step their fields serially
+    SerialSection serial;
+
+    while (true)
+    {
+        std::function<void()> task;
+        if (TryPop(worker, task))
+        {
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                queuedTasks--;
+            }
+            task();
+
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (--unfinishedTasks == 0)
+                allDone.notify_all();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(stateMutex);
+        if (stopping && queuedTasks == 0)
+            return;
+        taskAvailable.wait(lock, [this]() { return stopping || queuedTasks > 0; });
+        if (stopping && queuedTasks == 0)
+            return;
+    }
+}
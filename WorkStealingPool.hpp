@@ -0,0 +1,46 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// Fixed set of workers with one task deque each. A worker pops its own newest
+// task first and steals the oldest task of another worker when it runs dry.
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(unsigned int threadCount = std::thread::hardware_concurrency());
+    WorkStealingPool(WorkStealingPool const &) = delete;
+    void operator=(WorkStealingPool) = delete;
+    ~WorkStealingPool();
+
+    // tasks submitted from a worker land on that worker's own deque
+    void Submit(std::function<void()> task);
+    void Wait();
+
+    unsigned int GetThreadCount() const;
+
+private:
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool TryPop(unsigned int worker, std::function<void()>& task);
+    void WorkerTask(unsigned int worker);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex stateMutex;
+    std::condition_variable taskAvailable, allDone;
+    size_t queuedTasks, unfinishedTasks;
+    unsigned int nextQueue;
+    bool stopping;
+};